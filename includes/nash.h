@@ -87,6 +87,10 @@ int
 min1d(double *bb, double *st, double reltest, int *ifn, double *fnminval, 
       double (*fn1d)(double bb, int *notcomp));
 
+int 
+min1dn(int np, double *bb, double *st, double reltest, int *ifn, double *fnminval,
+       void (*fnnd)(int n, double *bb, double *fn, int *notcomp));
+
 int 
 modmrt(int n, int m, double *Bvec, double *Fmin, double reltest, int maxIter, 
        double (*nlres)(int i, int n, double *Bvec, int *notcomp), 
@@ -0,0 +1,100 @@
+#ifndef _Ordering_h
+#define _Ordering_h
+
+/*
+**++
+**  FACILITY:  Silicate Melts Regression/Crystallization Package
+**
+**  MODULE DESCRIPTION:
+**
+**      Common ordering-state storage and Newton step kernel for the
+**      order() routines of the solid solution models (file: ORDERING.H)
+**
+**      DECLARE_ORDERING_STATE(nr, ns) declares, in the including source
+**      file, the type OrderingState and the function getOrderingState().
+**      The state holds the T, P and composition of the last call to
+**      order(), the ordering parameters found and the inverse of the
+**      Hessian, d2g/ds2, at that solution, in fixed-size arrays that
+**      are fetched from thread-specific storage once per call.  A model
+**      without independent composition variables uses nr = 1.
+**
+**      orderingInverse() inverts the Hessian in place with the same
+**      full-pivoting Gauss-Jordan elimination, and the same fallback to
+**      the identity for a singular matrix, as gaussj() in recipes.c.
+**      It works on the contiguous array, without the row pointers and
+**      heap allocations of gaussj(), so results are unchanged.
+**--
+*/
+
+#define ORDERING_MAX_NS 8
+
+#define DECLARE_ORDERING_STATE(nr, ns) \
+typedef struct _orderingState { \
+  double t, p; \
+  double r[nr]; \
+  double s[ns]; \
+  double d2gds2[ns][ns]; \
+} OrderingState; \
+\
+static MTHREAD_ONCE_T initOrderingBlock = MTHREAD_ONCE_INIT; \
+static MTHREAD_KEY_T  orderingKey; \
+\
+static void threadOrderingInit(void) { \
+  MTHREAD_KEY_CREATE(&orderingKey, free); \
+} \
+\
+static OrderingState *getOrderingState(void) { \
+  OrderingState *state; \
+  MTHREAD_ONCE(&initOrderingBlock, threadOrderingInit); \
+\
+  state = (OrderingState *) MTHREAD_GETSPECIFIC(orderingKey); \
+  if (state == NULL) { \
+    int i; \
+    state = (OrderingState *) calloc((size_t) 1, sizeof(OrderingState)); \
+    state->t = -9999.0; \
+    state->p = -9999.0; \
+    for (i=0; i<(nr); i++) state->r[i] = -9999.0; \
+    for (i=0; i<(ns); i++) state->s[i] = 2.0; \
+    MTHREAD_SETSPECIFIC(orderingKey, (void *) state); \
+  } \
+  return state; \
+}
+
+static inline void orderingInverse(double *a, int n) {
+  int indxc[ORDERING_MAX_NS], indxr[ORDERING_MAX_NS], ipiv[ORDERING_MAX_NS];
+  int i, icol = -1, irow = -1, j, k, l, ll;
+  double big, dum, pivinv, temp;
+
+#define A(row, col) a[(row)*n+(col)]
+  for (j=0; j<n; j++) ipiv[j] = 0;
+  for (i=0; i<n; i++) {
+    big = 0.0;
+    for (j=0; j<n; j++) if (ipiv[j] != 1) for (k=0; k<n; k++) {
+      if (ipiv[k] == 0) {
+        if (fabs(A(j,k)) >= big) { big = fabs(A(j,k)); irow = j; icol = k; }
+      } else if (ipiv[k] > 1) nrerror("gaussj: Singular Matrix-1");
+    }
+    ++(ipiv[icol]);
+    if (irow != icol) for (l=0; l<n; l++) { temp = A(irow,l); A(irow,l) = A(icol,l); A(icol,l) = temp; }
+    indxr[i] = irow;
+    indxc[i] = icol;
+    if (A(icol,icol) == 0.0) {
+      /* as gaussj: returns the identity matrix as inverse instead of aborting */
+      for (j=0; j<n; j++) for (k=0; k<n; k++) A(j,k) = (j == k) ? 1.0 : 0.0;
+      return;
+    }
+    pivinv = 1.0/A(icol,icol);
+    A(icol,icol) = 1.0;
+    for (l=0; l<n; l++) A(icol,l) *= pivinv;
+    for (ll=0; ll<n; ll++) if (ll != icol) {
+      dum = A(ll,icol);
+      A(ll,icol) = 0.0;
+      for (l=0; l<n; l++) A(ll,l) -= A(icol,l)*dum;
+    }
+  }
+  for (l=n-1; l>=0; l--) if (indxr[l] != indxc[l])
+    for (k=0; k<n; k++) { temp = A(k,indxr[l]); A(k,indxr[l]) = A(k,indxc[l]); A(k,indxc[l]) = temp; }
+#undef A
+}
+
+#endif /* _Ordering_h */
@@ -521,6 +521,8 @@ extern int nlc;
 extern int nls;
 
 extern int liqERRstate;
+extern int speciationIterations;
+extern int saturationIterations;
 
 #define PHASE     1
 #define COMPONENT 0
@@ -610,6 +612,14 @@ typedef struct _solids {
 extern Solids *solids;
 extern int npc;
 
+/* Work space that silmin() and friends allocate on first use is sized for
+   the larger of these and the dimensions of the current solids[] table.
+   They are zero unless set by a caller that switches between tables
+   (libMelts), in which case they hold the largest npc and solids[].na,
+   solids[].nr of the tables it may switch to.  All liquid tables have the
+   same nlc.                                                                 */
+extern int workNpc, workNa, workNr;
+
 typedef struct _oxygen {
   double     *liqToOx; /* pointer to an array of length [nc] which converts
                           moles of liquid components to moles of oxygen      */
@@ -738,6 +748,24 @@ typedef struct _silminState {
   double  *yLiq;          /* array output from evaluateSaturationState       */
 } SilminState;   
 
+/* A state packed by packSilminState() into one buffer: this header, with the
+   scalar members of the state, followed by the arrays that are in use, i.e.
+   doubles for bulkComp, dspBulkComp, liquidComp[], liquidDelta[], the
+   solidComp[] and solidDelta[] columns of the phases present, fracSComp[]
+   and fracLComp, then (index, value) pairs for the entries of incSolids,
+   cylSolids, nSolidCoexist and nFracCoexist that differ from those of a new
+   state.                                                                    */
+typedef struct _compactState {
+  size_t size;         /* bytes in the buffer, this header included          */
+  int nLiquids;        /* liquid compositions stored                         */
+  int nInc;            /* incSolids entries that differ from the default     */
+  int nCyl;            /* non-zero cylSolids entries                         */
+  int nSolids;         /* non-zero nSolidCoexist entries                     */
+  int nFrac;           /* non-zero nFracCoexist entries; -1 if no fracSComp  */
+  int hasFracLiq;      /* TRUE if fracLComp is stored                        */
+  SilminState scalars; /* pointer members are not used                       */
+} CompactState;
+
 extern SilminState *silminState;
 
 #define SILMIN_STATE_CHANGE_NONE        0000000 /* octal mask   */
@@ -818,6 +846,7 @@ int         getAffinityAndComposition(double t, double p, int index, int *zeroX,
               double *muMinusMu0, double *affinity, double *indepVar);
 void        getEqualityConstraints(int *conRows, int *conCols, double ***cMatrixPt,
               double **hVectorPt, double **dVectorPt, double **yVectorPt);
+int         getEquilibriumSensitivities(double ***dPhaseOx, int *rankDeficient);
 double      getlog10fo2(double t, double p, int buffer);
 double      getdlog10fo2dt(double t, double p, int buffer);
 double      getdlog10fo2dp(double t, double p, int buffer);
@@ -826,6 +855,8 @@ double      getd2log10fo2dp2(double t, double p, int buffer);
 int         getProjGradientAndHessian(int conRows, int conCols, double ***eMatrixPt, 
               double ***bMatrixPt, double **cMatrix, double *hVector, double *dVector, 
               double *yVector);
+void        gmixSolN(int index, int mask, double t, double p, int n, int ld,
+              double *x, double *gmix, double *dx);
 void        gibbs(double t, double p, char *name, ThermoRef *phase, 
               ThermoLiq *liquid, ThermoData *fusion, ThermoData *result);
 void        InitComputeDataStruct(void);
@@ -835,10 +866,13 @@ void        intenToExtenHessian(double pMix, double *dpMix, double **d2pMix,
               int nr, double **d2p, int na, double mTotal, double **drdm,
               double ***d2rdm2);
 double      linearSearch(double lambda, int *notcomp);
+void        linearSearchN(int n, double *lambda, double *pTotal, int *notcomp);
+CompactState *packSilminState(SilminState *p);
 int         spinodeTest(void);
 int         subsolidusmuO2(int mask, double *muO2, double *dm, double *dt, double *dp,
               double **d2m, double *d2mt, double *d2mp, double *d2t2, double *d2tp, 
               double *d2p2);
+SilminState *unpackSilminState(CompactState *c);
 void        updateAssimilantPADB(char *member);
 void        updateBulkADB(void);
 void        updateSolidADB(double *rSol, double *rLiq);
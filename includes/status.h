@@ -45,4 +45,56 @@ typedef struct _meltsStatus {
 } MeltsStatus;
 extern MeltsStatus meltsStatus;
 
+/* Limits on a single equilibration in silmin(), checked between steps of its
+   state machine; a value of zero means no limit.  When a limit is reached
+   silmin() returns TRUE with status SILMIN_TIME, leaving in silminState the
+   best acceptable quadratic iterate if there is one, else the current one. */
+
+typedef struct _meltsBudget {
+  double wallTime;             /* seconds of elapsed time                       */
+  int    quadIterations;       /* quadratic minimization iterations             */
+  int    speciationIterations; /* iterations in the liquid speciation routines */
+} MeltsBudget;
+extern MeltsBudget meltsBudget;
+
+/* Set by the caller before an equilibration that starts from a converged
+   state in silminState and differs from it only by a small change in bulk
+   composition.  silmin() then keeps the current assemblage, skipping the
+   initial saturation check; the check made after convergence still adds any
+   phase that has become saturated.  Cleared by silmin() on use.             */
+
+extern int meltsWarmStart;
+
+/* When set, liquidus() remembers the liquidus temperatures it finds and starts
+   the search for a new composition at a temperature predicted from the
+   nearest of them, with a step set by the spread of their temperatures.  It
+   widens the step if the prediction fails to bracket the liquidus; the
+   search still ends when the step falls below 0.1 K.                       */
+
+extern int meltsLiquidusSurrogate;
+
+/* When set, silmin() calls this function with each converged assemblage of a
+   path in place of writing its output files.                                */
+
+extern void (*meltsStepOutput)(void);
+
+/* Adaptive steps along a path.  When adaptive is set, silmin() scales the
+   temperature, pressure and assimilant increments of the path by a common
+   factor, between minScale and maxScale, so the shape of the path is kept.
+   The factor doubles after a step in which the assemblage is unchanged and
+   the liquid changes by less than half of maxChange (mass fraction of the
+   system).  A step that adds or drops a phase, or changes the liquid by more
+   than maxChange, is discarded and retried from the previous converged state
+   with half the factor; after a discarded step that changed the assemblage
+   the factor keeps halving until the change is found within the smallest
+   step.  Changes of assemblage are recorded in melts-events.out.           */
+
+typedef struct _meltsStepControl {
+  int    adaptive;   /* TRUE to adapt the steps of a path                     */
+  double minScale;   /* smallest step, as a multiple of the increments        */
+  double maxScale;   /* largest step, as a multiple of the increments         */
+  double maxChange;  /* largest change in liquid mass fraction in one step    */
+} MeltsStepControl;
+extern MeltsStepControl meltsStepControl;
+
 #endif /* _Status_h */
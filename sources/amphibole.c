@@ -68,6 +68,7 @@ MELTS Source Code: RCS
 
 #include "silmin.h"   /* Structure definitions for SILMIN package      */ 
 #include "recipes.h"  /* Numerical recipes routines                    */
+#include "ordering.h" /* Ordering state of solution models      */
 
 #define SQUARE(x) ((x)*(x))
 #define CUBE(x)   ((x)*(x)*(x))
@@ -342,102 +343,14 @@ static void setClino(int clino) {
 /* Statics for Ordering Calculations */
 /*************************************/
 
+DECLARE_ORDERING_STATE(NR, NS)
+
 static MTHREAD_ONCE_T initThreadOBlock = MTHREAD_ONCE_INIT;
 
-static MTHREAD_KEY_T tOldKey;
-static MTHREAD_KEY_T pOldKey;
-static MTHREAD_KEY_T rOldKey;
 static MTHREAD_KEY_T structOldKey;
-static MTHREAD_KEY_T sOldKey;
-static MTHREAD_KEY_T d2gds2Key;
-static MTHREAD_KEY_T ptToD2gds2Key;
-
-static void freeNSarray(void *NSarray) {
-  free_vector((double *) NSarray, 0, NS-1);
-}
-
-static void freeD2gds2(void *d2gds2) {
-  free_matrix((double **) d2gds2, 0, NS-1, 0, NS-1);
-}
-
-static void freePtToD2gds2(void *ptToD2gds2) {
-  free_submatrix((double **) ptToD2gds2, 1, NS, 1, NS);
-}
 
 static void threadOInit(void) {
-  MTHREAD_KEY_CREATE(&tOldKey,       free);
-  MTHREAD_KEY_CREATE(&pOldKey,       free);
-  MTHREAD_KEY_CREATE(&rOldKey,       freeNSarray);
   MTHREAD_KEY_CREATE(&structOldKey,  free);
-  MTHREAD_KEY_CREATE(&sOldKey,       freeNSarray);
-  MTHREAD_KEY_CREATE(&d2gds2Key,     freeD2gds2);
-  MTHREAD_KEY_CREATE(&ptToD2gds2Key, freePtToD2gds2);
-}
-
-static double getTOld() {
-  double *tOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  tOldPt = (double *) MTHREAD_GETSPECIFIC(tOldKey);   
-  if (tOldPt == NULL) {
-    tOldPt  = (double *) malloc(sizeof(double)); 
-    *tOldPt = -9999.0;    
-    MTHREAD_SETSPECIFIC(tOldKey, (void *) tOldPt);
-  }
-  return *tOldPt;
-}
-
-static void setTOld(double tOld) {
-  double *tOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  tOldPt = (double *) MTHREAD_GETSPECIFIC(tOldKey);   
-  if (tOldPt == NULL) {
-    tOldPt  = (double *) malloc(sizeof(double)); 
-    *tOldPt = -9999.0;    
-    MTHREAD_SETSPECIFIC(tOldKey, (void *) tOldPt);
-  }
-  *tOldPt = tOld;
-}
-
-static double getPOld() {
-  double *pOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  pOldPt = (double *) MTHREAD_GETSPECIFIC(pOldKey);   
-  if (pOldPt == NULL) {
-    pOldPt  = (double *) malloc(sizeof(double)); 
-    *pOldPt = -9999.0;    
-    MTHREAD_SETSPECIFIC(pOldKey, (void *) pOldPt);
-  }
-  return *pOldPt; 
-}
-
-static void setPOld(double pOld) {
-  double *pOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  pOldPt = (double *) MTHREAD_GETSPECIFIC(pOldKey);   
-  if (pOldPt == NULL) {
-    pOldPt  = (double *) malloc(sizeof(double)); 
-    *pOldPt = -9999.0;    
-    MTHREAD_SETSPECIFIC(pOldKey, (void *) pOldPt);
-  }
-  *pOldPt = pOld; 
-}
-
-static double *getROld() {
-  double *rOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  rOldPt = (double *) MTHREAD_GETSPECIFIC(rOldKey);   
-  if (rOldPt == NULL) {
-    int i;
-    rOldPt = vector(0, NR-1);
-    for (i=0; i<NR; i++) rOldPt[i] = -9999.0;    
-    MTHREAD_SETSPECIFIC(rOldKey, (void *) rOldPt);
-  }
-  return rOldPt; 
 }
 
 static int getStructOld() {
@@ -466,46 +379,6 @@ static void setStructOld(int structOld) {
   *structOldPt = structOld;
 }
 
-static double *getSOld() {
-  double *sOldPt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  sOldPt = (double *) MTHREAD_GETSPECIFIC(sOldKey);   
-  if (sOldPt == NULL) {
-    int i;
-    sOldPt = vector(0, NS-1);
-    for (i=0; i<NS; i++) sOldPt[i] = 2.0;    
-    MTHREAD_SETSPECIFIC(sOldKey, (void *) sOldPt);
-  }
-  return sOldPt;
-}
-
-static double **getD2gds2() {
-  double **d2gds2Pt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  d2gds2Pt = (double **) MTHREAD_GETSPECIFIC(d2gds2Key);   
-  if (d2gds2Pt == NULL) {
-    int i, j;
-    d2gds2Pt  = matrix(0, NS-1, 0, NS-1);
-    for (i=0; i<NS; i++) for (j=0; j<NS; j++) d2gds2Pt[i][j] = 0.0;
-    MTHREAD_SETSPECIFIC(d2gds2Key, (void *) d2gds2Pt);
-  }
-  return d2gds2Pt; 
-}
-
-static double **getPtToD2gds2() {
-  double **ptToD2gds2Pt;
-  MTHREAD_ONCE(&initThreadOBlock, threadOInit);
-  
-  ptToD2gds2Pt = (double **) MTHREAD_GETSPECIFIC(ptToD2gds2Key);   
-  if (ptToD2gds2Pt == NULL) {
-    ptToD2gds2Pt = submatrix(getD2gds2(), 0, NS-1, 0, NS-1, 1, 1);
-    MTHREAD_SETSPECIFIC(ptToD2gds2Key, (void *) ptToD2gds2Pt);
-  }
-  return ptToD2gds2Pt;
-}
-
 /***********************************/
 /* Statics for Site Mole Fractions */
 /***********************************/
@@ -974,12 +847,12 @@ order(int mask, double t, double p, double r[NR],
 {
   DECLARE_SITE_FRACTIONS
   int clino           = getClino();
-  double tOld         = getTOld();
-  double pOld         = getPOld();
-  double *rOld        = getROld();
-  double *sOld        = getSOld();
-  double **d2gds2     = getD2gds2();
-  double **ptToD2gds2 = getPtToD2gds2();
+  OrderingState *state  = getOrderingState();
+  double tOld           = state->t;
+  double pOld           = state->p;
+  double *rOld          = state->r;
+  double *sOld          = state->s;
+  double (*d2gds2)[NS]  = state->d2gds2;
   int    structOld    = getStructOld();
   
   int i, j, iter=0;
@@ -1039,7 +912,7 @@ order(int mask, double t, double p, double r[NR],
 
       for (i=0; i<NS; i++) sOld[i] = s[i];
 
-      gaussj(ptToD2gds2, NS, (double **) NULL, 0);
+      orderingInverse(&d2gds2[0][0], NS);
 
       for (i=0; i<NS; i++) {
         for(j=0, sCorr[i]=0.0; j<NS; j++) sCorr[i] += - d2gds2[i][j]*dgds[j];
@@ -1089,8 +962,8 @@ order(int mask, double t, double p, double r[NR],
     }
 #endif
 
-    setTOld(tOld);
-    setPOld(pOld);
+    state->t = tOld;
+    state->p = pOld;
     setStructOld(structOld);
     /* arrays (rOld, sOld, d2gds2) should be preserved automatically */
 
@@ -0,0 +1,506 @@
+/*
+**++
+**  FACILITY:  Silicate Melts Crystallization Package
+**
+**  MODULE DESCRIPTION:
+**
+**      Phase-saturation barometry engine (file: BAROMETRY.C)
+**
+**      Melts-barometry [-w workers] [-t seconds] [-P Pstart,Pstop,Pinc]
+**                      [-T Tstart,Tstop,Tinc] [-h H2O] [-f deltaQFM]
+**                      [-o results] [-v] compositions.csv
+**
+**      Reads a table of glass compositions and, for every sample and every
+**      pressure, runs an isobaric cooling path (rhyolite-MELTS, fO2 on the
+**      QFM buffer) recording the temperatures at which quartz, plagioclase
+**      and alkali feldspar saturate.  All results are written to one file.
+**
+**      The composition table is comma separated.  The first line is a
+**      header: the first column holds the sample label and the remaining
+**      columns are oxide names (SiO2, TiO2, Al2O3, FeO, ...) in wt %.  If
+**      there is no H2O column, the value given with -h is used.  Lines
+**      starting with # are ignored.
+**
+**      The model is initialized once.  Paths are run by a pool of worker
+**      processes forked from the initialized image; silmin() keeps its
+**      state in process globals, so each worker runs one path at a time.
+**      A path that exceeds its CPU budget (-t, 15 s by default, 0 for
+**      none) is abandoned and reported as a timeout; the worker is
+**      replaced.  A path stops as soon as all three phases have saturated.
+**
+**      Replaces the shell-out loops of Guil-driver.c and friends, which
+**      started a Test_commandLib process per sample and pressure.
+**--
+*/
+
+#include <ctype.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "silmin.h"
+#include "status.h"
+
+int setCalculationMode(int mode);
+
+#define BAROMETRY_SUCCESS 0
+#define BAROMETRY_FAILURE 1
+#define BAROMETRY_TIMEOUT 2
+
+#define NOT_SATURATED     (-1.0)
+
+typedef struct _barometryResult {
+  int    task;
+  int    status;
+  double tQuartz;      /* saturation temperatures (K), NOT_SATURATED if none */
+  double tPlagioclase;
+  double tAlkaliFeldspar;
+} BarometryResult;
+
+typedef struct _worker {
+  pid_t pid;
+  int   taskFd;        /* parent -> worker, task index, -1 to quit           */
+  int   resultFd;      /* worker -> parent, BarometryResult                  */
+  int   task;          /* task in progress, -1 if idle                       */
+} Worker;
+
+static int      nSamples;
+static char   **sampleLabel;
+static double **sampleWt;       /* [nSamples][nc] wt % oxides                */
+
+static int      nPressures;
+static double  *pressure;       /* bars                                      */
+
+static double tStart = 1000.0, tStop = 700.0, tInc = 1.0; /* C */
+static double defaultH2O = 10.0, deltaQFM = 0.0;
+static int    cpuLimit = 15, verbose = FALSE;
+
+static int iQuartz = -1, iFeldspar = -1, iAlbite = -1, iSanidine = -1, iH2O = -1;
+
+/* ================================================================================== */
+/* Input                                                                              */
+/* ================================================================================== */
+
+static char *trim(char *s) {
+  char *e;
+  while (isspace((unsigned char) *s)) s++;
+  for (e=s+strlen(s); (e > s) && isspace((unsigned char) e[-1]); e--) ;
+  *e = '\0';
+  return s;
+}
+
+/* Splits a line in place on commas; returns the number of fields */
+static int splitFields(char *line, char **field, int maxFields) {
+  int n = 0;
+  char *s = line, *c;
+  while (n < maxFields) {
+    field[n++] = s;
+    if ((c = strchr(s, ',')) == NULL) break;
+    *c = '\0';
+    s = c + 1;
+  }
+  for (c=s; *c != '\0'; c++) if (*c == ',') return -1;
+  return n;
+}
+
+static void readCompositions(char *fileName) {
+  FILE *fp;
+  char line[4096], *field[64];
+  int column[64], nColumns = 0, hasH2O = FALSE, lineNo = 0, i, j, n;
+
+  if ((fp = fopen(fileName, "r")) == NULL) {
+    fprintf(stderr, "Cannot open composition table %s.\n", fileName);
+    exit(1);
+  }
+
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char *s = trim(line);
+    lineNo++;
+    if ((*s == '\0') || (*s == '#')) continue;
+    if ((n = splitFields(s, field, 64)) < 2) {
+      fprintf(stderr, "Line %d of %s: expected at least two comma separated fields (or too many).\n", lineNo, fileName);
+      exit(1);
+    }
+
+    if (nColumns == 0) {
+      for (i=1; i<n; i++) {
+        char *name = trim(field[i]);
+        for (j=0; j<nc; j++) if (!strcasecmp(name, bulkSystem[j].label)) break;
+        if (j == nc) {
+          fprintf(stderr, "Line %d of %s: %s is not a MELTS oxide.\n", lineNo, fileName, name);
+          exit(1);
+        }
+        if (j == iH2O) hasH2O = TRUE;
+        column[i] = j;
+      }
+      nColumns = n;
+      continue;
+    }
+
+    if (n != nColumns) {
+      fprintf(stderr, "Line %d of %s: %d fields, header has %d.\n", lineNo, fileName, n, nColumns);
+      exit(1);
+    }
+    sampleLabel = (char **)   realloc(sampleLabel, (size_t) (nSamples+1)*sizeof(char *));
+    sampleWt    = (double **) realloc(sampleWt,    (size_t) (nSamples+1)*sizeof(double *));
+    sampleLabel[nSamples] = strdup(trim(field[0]));
+    sampleWt[nSamples]    = (double *) calloc((size_t) nc, sizeof(double));
+    for (i=1; i<n; i++) {
+      char *pEnd, *value = trim(field[i]);
+      sampleWt[nSamples][column[i]] = (*value == '\0') ? 0.0 : strtod(value, &pEnd);
+      if ((*value != '\0') && (*pEnd != '\0')) {
+        fprintf(stderr, "Line %d of %s: cannot read %s as a number.\n", lineNo, fileName, value);
+        exit(1);
+      }
+    }
+    if (!hasH2O) sampleWt[nSamples][iH2O] = defaultH2O;
+    nSamples++;
+  }
+  fclose(fp);
+
+  if (nSamples == 0) {
+    fprintf(stderr, "No compositions found in %s.\n", fileName);
+    exit(1);
+  }
+}
+
+static int readRange(char *arg, double *start, double *stop, double *inc) {
+  return (sscanf(arg, "%lf,%lf,%lf", start, stop, inc) == 3);
+}
+
+static void makePressures(double pStart, double pStop, double pInc) {
+  int i;
+  if (pInc <= 0.0) pInc = fabs(pStart - pStop) + 1.0;
+  nPressures = (int) floor(fabs(pStart - pStop)/pInc + 1.0e-6) + 1;
+  pressure   = (double *) malloc((size_t) nPressures*sizeof(double));
+  for (i=0; i<nPressures; i++) pressure[i] = (pStop < pStart) ? pStart - i*pInc : pStart + i*pInc;
+}
+
+/* ================================================================================== */
+/* One isobaric cooling path                                                          */
+/* ================================================================================== */
+
+static void findPhases(void) {
+  int i, j;
+  for (i=0; i<nc; i++) if (!strcmp(bulkSystem[i].label, "H2O")) iH2O = i;
+  for (i=0; i<npc; i++) if (solids[i].type == PHASE) {
+    if      (!strcmp(solids[i].label, "quartz"))   iQuartz   = i;
+    else if (!strcmp(solids[i].label, "feldspar")) {
+      iFeldspar = i;
+      for (j=0; j<solids[i].na; j++) {
+        if      (!strcmp(solids[i+1+j].label, "albite"))   iAlbite   = i+1+j;
+        else if (!strcmp(solids[i+1+j].label, "sanidine")) iSanidine = i+1+j;
+      }
+    }
+  }
+  if ((iQuartz == -1) || (iFeldspar == -1) || (iAlbite == -1) || (iSanidine == -1)) {
+    fprintf(stderr, "The solid phase tables lack quartz or feldspar.\n");
+    exit(1);
+  }
+}
+
+/* Feldspars with more sanidine than albite component count as alkali feldspar */
+static void recordSaturation(double t, BarometryResult *result) {
+  int ns;
+
+  if ((result->tQuartz == NOT_SATURATED) && ((silminState->nSolidCoexist)[iQuartz] > 0)) result->tQuartz = t;
+  for (ns=0; ns<(silminState->nSolidCoexist)[iFeldspar]; ns++) {
+    if ((silminState->solidComp)[iSanidine][ns] > (silminState->solidComp)[iAlbite][ns]) {
+      if (result->tAlkaliFeldspar == NOT_SATURATED) result->tAlkaliFeldspar = t;
+    } else {
+      if (result->tPlagioclase    == NOT_SATURATED) result->tPlagioclase    = t;
+    }
+  }
+}
+
+static void runPath(int task, BarometryResult *result) {
+  double *wt = sampleWt[task/nPressures], p = pressure[task%nPressures], t;
+  int i, j, done;
+
+  result->task            = task;
+  result->status          = BAROMETRY_SUCCESS;
+  result->tQuartz         = NOT_SATURATED;
+  result->tPlagioclase    = NOT_SATURATED;
+  result->tAlkaliFeldspar = NOT_SATURATED;
+
+  silminState = allocSilminStatePointer();
+  for (i=0, j=0; i<npc; i++) if (solids[i].type == PHASE) {
+    if      (!strcmp(solids[i].label, "fayalite"))      (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "garnet"))        (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "melilite"))      (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "hornblende"))    (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "fluid"))         (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "cummingtonite")) (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "amphibole"))     (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "nepheline"))     (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "kalsilite"))     (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "ortho-oxide"))   (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "alloy-solid"))   (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "alloy-liquid"))  (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "lime"))          (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "periclase"))     (silminState->incSolids)[j] = FALSE;
+    else if (!strcmp(solids[i].label, "leucite"))       (silminState->incSolids)[j] = FALSE;
+    else                                                (silminState->incSolids)[j] = TRUE;
+    j++;
+  }
+  (silminState->incSolids)[npc] = TRUE;
+  silminState->nLiquidCoexist  = 1;
+  silminState->fo2Path  = FO2_QFM;
+  silminState->fo2Delta = deltaQFM;
+
+  silminState->fractionateFlu = FALSE;
+  silminState->fractionateSol = FALSE;
+  silminState->fractionateLiq = FALSE;
+
+  for (i=0, silminState->liquidMass=0.0; i<nc; i++) {
+    (silminState->bulkComp)[i] = wt[i]/bulkSystem[i].mw;
+    silminState->liquidMass += wt[i];
+  }
+  for (i=0; i<nlc; i++)
+    for ((silminState->liquidComp)[0][i]=0.0, silminState->oxygen=0.0, j=0; j<nc; j++) {
+      (silminState->liquidComp)[0][i] += (silminState->bulkComp)[j]*(bulkSystem[j].oxToLiq)[i];
+      silminState->oxygen += (silminState->bulkComp)[j]*(bulkSystem[j].oxToLiq)[i]*(oxygen.liqToOx)[i];
+    }
+
+  silminState->isenthalpic = FALSE;
+  silminState->isentropic  = FALSE;
+  silminState->isochoric   = FALSE;
+  silminState->T           = tStart + 273.15;
+  silminState->dspTstart   = tStart + 273.15;
+  silminState->dspTstop    = tStop  + 273.15;
+  silminState->dspTinc     = tInc;
+  silminState->P           = p;
+  silminState->dspPstart   = p;
+  silminState->dspPstop    = p;
+  silminState->dspPinc     = 0.0;
+  silminState->dspDPDH     = 0.0;
+
+  /* silmin() changes T only once the assemblage at the previous T has been
+     output, and returns with its step counter reset, so the path may be
+     abandoned there.                                                        */
+  do {
+    t    = silminState->T;
+    done = silmin();
+    if (done && (meltsStatus.status != SILMIN_SUCCESS)) {
+      result->status = BAROMETRY_FAILURE;
+      break;
+    }
+    if (done || (silminState->T != t)) recordSaturation(t, result);
+  } while (!done && ((result->tQuartz         == NOT_SATURATED) ||
+                     (result->tPlagioclase    == NOT_SATURATED) ||
+                     (result->tAlkaliFeldspar == NOT_SATURATED)));
+
+  destroySilminStateStructure(silminState);
+  silminState = NULL;
+}
+
+/* ================================================================================== */
+/* Worker pool                                                                        */
+/* ================================================================================== */
+
+static int readFully(int fd, void *buffer, size_t size) {
+  size_t n = 0;
+  while (n < size) {
+    ssize_t m = read(fd, (char *) buffer + n, size - n);
+    if (m <= 0) return FALSE;
+    n += (size_t) m;
+  }
+  return TRUE;
+}
+
+static void workerLoop(int taskFd, int resultFd) {
+  BarometryResult result;
+  struct rlimit limit;
+  struct rusage usage;
+  int task;
+
+  if (!verbose) {
+    (void) freopen("/dev/null", "w", stdout);
+    (void) freopen("/dev/null", "w", stderr);
+  }
+
+  while (readFully(taskFd, &task, sizeof(int)) && (task >= 0)) {
+    if (cpuLimit > 0) {
+      getrusage(RUSAGE_SELF, &usage);
+      getrlimit(RLIMIT_CPU, &limit);
+      limit.rlim_cur = (rlim_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + 1 + cpuLimit);
+      if ((limit.rlim_max != RLIM_INFINITY) && (limit.rlim_cur > limit.rlim_max)) limit.rlim_cur = limit.rlim_max;
+      setrlimit(RLIMIT_CPU, &limit);
+    }
+    runPath(task, &result);
+    if (write(resultFd, &result, sizeof(BarometryResult)) != sizeof(BarometryResult)) break;
+  }
+  _exit(0);
+}
+
+static void startWorker(Worker *worker, Worker *pool, int nWorkers) {
+  int toWorker[2], toParent[2], i;
+
+  if ((pipe(toWorker) != 0) || (pipe(toParent) != 0)) {
+    perror("Melts-barometry: pipe");
+    exit(1);
+  }
+  if ((worker->pid = fork()) < 0) {
+    perror("Melts-barometry: fork");
+    exit(1);
+  } else if (worker->pid == 0) {
+    for (i=0; i<nWorkers; i++) if ((pool+i != worker) && (pool[i].pid > 0)) {
+      close(pool[i].taskFd);
+      close(pool[i].resultFd);
+    }
+    close(toWorker[1]);
+    close(toParent[0]);
+    workerLoop(toWorker[0], toParent[1]);
+  }
+  close(toWorker[0]);
+  close(toParent[1]);
+  worker->taskFd   = toWorker[1];
+  worker->resultFd = toParent[0];
+  worker->task     = -1;
+}
+
+static void stopWorker(Worker *worker) {
+  int quit = -1;
+  (void) write(worker->taskFd, &quit, sizeof(int));
+  close(worker->taskFd);
+  close(worker->resultFd);
+  waitpid(worker->pid, NULL, 0);
+  worker->pid = 0;
+}
+
+static int sendTask(Worker *worker, int task) {
+  worker->task = task;
+  return (write(worker->taskFd, &task, sizeof(int)) == sizeof(int));
+}
+
+static void runTasks(int nWorkers, BarometryResult *results) {
+  Worker *pool = (Worker *) calloc((size_t) nWorkers, sizeof(Worker));
+  struct pollfd *fds = (struct pollfd *) calloc((size_t) nWorkers, sizeof(struct pollfd));
+  int nTasks = nSamples*nPressures, next = 0, nDone = 0, i;
+
+  signal(SIGPIPE, SIG_IGN);
+  for (i=0; (i<nWorkers) && (next<nTasks); i++) {
+    startWorker(&pool[i], pool, nWorkers);
+    (void) sendTask(&pool[i], next++);
+  }
+
+  while (nDone < nTasks) {
+    for (i=0; i<nWorkers; i++) {
+      fds[i].fd     = (pool[i].pid > 0) ? pool[i].resultFd : -1;
+      fds[i].events = POLLIN;
+    }
+    if (poll(fds, (nfds_t) nWorkers, -1) < 0) continue;
+
+    for (i=0; i<nWorkers; i++) if ((pool[i].pid > 0) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+      BarometryResult result;
+
+      if (readFully(pool[i].resultFd, &result, sizeof(BarometryResult))) {
+        results[result.task] = result;
+      } else {
+        /* worker died on the path it was running */
+        int status;
+        close(pool[i].taskFd);
+        close(pool[i].resultFd);
+        waitpid(pool[i].pid, &status, 0);
+        pool[i].pid = 0;
+        results[pool[i].task].task   = pool[i].task;
+        results[pool[i].task].status = (WIFSIGNALED(status) && (WTERMSIG(status) == SIGXCPU || WTERMSIG(status) == SIGKILL))
+                                     ? BAROMETRY_TIMEOUT : BAROMETRY_FAILURE;
+        results[pool[i].task].tQuartz = results[pool[i].task].tPlagioclase = results[pool[i].task].tAlkaliFeldspar = NOT_SATURATED;
+        if (next < nTasks) startWorker(&pool[i], pool, nWorkers);
+      }
+      nDone++;
+      if (verbose) fprintf(stderr, "Melts-barometry: %d of %d paths done.\n", nDone, nTasks);
+
+      if (pool[i].pid > 0) {
+        if (next < nTasks) (void) sendTask(&pool[i], next++);
+        else               stopWorker(&pool[i]);
+      }
+    }
+  }
+
+  for (i=0; i<nWorkers; i++) if (pool[i].pid > 0) stopWorker(&pool[i]);
+  free(fds);
+  free(pool);
+}
+
+/* ================================================================================== */
+/* Output                                                                             */
+/* ================================================================================== */
+
+static void putTemperature(FILE *fp, double t) {
+  if (t == NOT_SATURATED) fprintf(fp, ",");
+  else                    fprintf(fp, ",%.2f", t - 273.15);
+}
+
+static void writeResults(char *fileName, BarometryResult *results) {
+  static const char *statusName[] = { "success", "failure", "timeout" };
+  FILE *fp = (fileName != NULL) ? fopen(fileName, "w") : stdout;
+  int task;
+
+  if (fp == NULL) {
+    fprintf(stderr, "Cannot open results file %s.\n", fileName);
+    exit(1);
+  }
+  fprintf(fp, "sample,P (bars),status,T quartz (C),T plagioclase (C),T alkali feldspar (C)\n");
+  for (task=0; task<nSamples*nPressures; task++) {
+    fprintf(fp, "%s,%.1f,%s", sampleLabel[task/nPressures], pressure[task%nPressures], statusName[results[task].status]);
+    putTemperature(fp, results[task].tQuartz);
+    putTemperature(fp, results[task].tPlagioclase);
+    putTemperature(fp, results[task].tAlkaliFeldspar);
+    fprintf(fp, "\n");
+  }
+  if (fp != stdout) fclose(fp);
+}
+
+/* ================================================================================== */
+
+static void usage(void) {
+  fprintf(stderr, "Usage: Melts-barometry [-w workers] [-t seconds] [-P Pstart,Pstop,Pinc (bars)]\n");
+  fprintf(stderr, "                       [-T Tstart,Tstop,Tinc (C)] [-h H2O (wt %%)] [-f deltaQFM]\n");
+  fprintf(stderr, "                       [-o results] [-v] compositions.csv\n");
+  exit(1);
+}
+
+int main (int argc, char *argv[]) {
+  double pStart = 4000.0, pStop = 250.0, pInc = 250.0;
+  char *outputFile = NULL;
+  int nWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN), c;
+  BarometryResult *results;
+
+  while ((c = getopt(argc, argv, "w:t:P:T:h:f:o:v")) != -1) switch (c) {
+    case 'w': nWorkers   = atoi(optarg);   break;
+    case 't': cpuLimit   = atoi(optarg);   break;
+    case 'h': defaultH2O = atof(optarg);   break;
+    case 'f': deltaQFM   = atof(optarg);   break;
+    case 'o': outputFile = optarg;         break;
+    case 'v': verbose    = TRUE;           break;
+    case 'P': if (!readRange(optarg, &pStart, &pStop, &pInc)) usage(); break;
+    case 'T': if (!readRange(optarg, &tStart, &tStop, &tInc)) usage(); break;
+    default:  usage();
+  }
+  if (optind != argc-1) usage();
+  if (nWorkers < 1) nWorkers = 1;
+
+  silminInputData.name = "Melts-barometry";
+  (void) setCalculationMode(MODE__MELTS);
+  findPhases();
+
+  readCompositions(argv[optind]);
+  makePressures(pStart, pStop, pInc);
+
+  results = (BarometryResult *) calloc((size_t) nSamples*nPressures, sizeof(BarometryResult));
+  runTasks(nWorkers, results);
+  writeResults(outputFile, results);
+
+  exit(0);
+}
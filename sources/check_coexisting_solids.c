@@ -397,6 +397,8 @@ static void initializeGlobalStatics(void) {
     if (solids[i].nr > nr) nr = solids[i].nr;
     if (solids[i].na > na) na = solids[i].na;
   }
+  nr = MAX(nr, workNr);
+  na = MAX(na, workNa);
 
   bRef      = (double *)  malloc((unsigned) nr*sizeof(double));
   dg	    = (double *)  malloc((unsigned) nr*sizeof(double));
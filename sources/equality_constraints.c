@@ -169,17 +169,17 @@ void getEqualityConstraints(int *conRows, int *conCols, double ***cMatrixPt,
   int hasLiquid   = (silminState->liquidMass  != 0.0);
 
   if ((isenthalpic || isochoric || isentropic  || (silminState->fo2Path != FO2_NONE)) && constraints == NULL) {
-    int na = 0;
+    int na = 0, npcW = MAX(npc, workNpc);
     constraints = (Constraints *) malloc((unsigned) sizeof(Constraints));
     constraints->lambda = (double *) malloc((size_t) (2*nc+4)*sizeof(double)); /* nc components, + nc fO2 constraints + 1 + V + S + H  (there are at most nc 
                                                                                   coexisting liquids, each with an fO2 constraint plus - perhaps - and 
 										  additional fO2 constraint for the solid phase)    */
     constraints->liquidDelta = (double **) malloc((size_t) nlc*sizeof(double *));                       /* nlc coexisting liquids   */
     for (i=0; i<nlc; i++) constraints->liquidDelta[i] = (double *) malloc((size_t) nlc*sizeof(double)); /* each with nlc components */   
-    constraints->solidDelta = (double **) malloc((size_t) npc*sizeof(double *));                        /* npc solid phases         */ 
-    for (i=0; i<npc; i++) {
-      if (solids[i].type == PHASE) na = MAX(solids[i].na, 1); 
-      constraints->solidDelta[i] = (double *) malloc((size_t) na*sizeof(double));                       /* na coexisting solids     */
+    constraints->solidDelta = (double **) malloc((size_t) npcW*sizeof(double *));                       /* npc solid phases         */ 
+    for (i=0; i<npcW; i++) {
+      if ((i < npc) && (solids[i].type == PHASE)) na = MAX(solids[i].na, 1); 
+      constraints->solidDelta[i] = (double *) malloc((size_t) MAX(na, workNa)*sizeof(double));          /* na coexisting solids     */
     }
     constraints->lambdaO2 = (double *) malloc((size_t)   (nc+1)*sizeof(double));                        /* There are at most nc (liquid) + 1 (solid) fO2 cons  */
     for (i=0; i<nc; i++) {
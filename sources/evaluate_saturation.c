@@ -144,18 +144,36 @@ int getAffinityAndCompositionPyroxene(double t, double p, int index,
 
 int evaluateSaturationState(double *rSol, double *rLiq)
 {
-  static int *zeroX;
+  static int *zeroX, *liqCompPresent;
   static double *muSol, *xSol, *muLiq, *muTemp, *liquidComp;
+  /* Workspace of the subsolidus case.  The stoichiometry of the solid
+     endmembers present in terms of the liquid components only changes with
+     the assemblage, so its SVD (u, w, v) is kept with the matrix it was
+     computed for (stoichSVD, stoichRows x stoichCols) and only redone when
+     the matrix of a call differs from that one.                          */
+  static double **stoichMatrix, **stoichSVD, **u, **v, *w, *muAllSol, *muAllLiq, *wInvUb;
+  static int stoichRows = 0, stoichCols = 0;
   int i, j, k, l = 0, hasSupersat;
   double t, p;
 
   if (muLiq == NULL) {
+    int npcW = MAX(npc, workNpc);
     muLiq      = (double *) malloc((unsigned) nlc*sizeof(double));
     muSol      = (double *) malloc((unsigned) nlc*sizeof(double));
     xSol       = (double *) malloc((unsigned) nlc*sizeof(double));
     zeroX      = (int *)    malloc((unsigned) nlc*sizeof(int));
     muTemp     = (double *) calloc((unsigned) nlc, sizeof(double));
     liquidComp = (double *) calloc((unsigned) nlc, sizeof(double));
+
+    liqCompPresent = (int *) malloc((unsigned) nlc*sizeof(int));
+    stoichMatrix   = dmatrix(1,npcW,1,nlc+1);
+    stoichSVD      = dmatrix(1,npcW,1,nlc+1);
+    u              = dmatrix(1,npcW,1,nlc+1);
+    v              = dmatrix(1,nlc+1,1,nlc+1);
+    w              = dvector(1,nlc+1);
+    muAllSol       = dvector(1,npcW);
+    muAllLiq       = dvector(1,nlc+1);
+    wInvUb         = dvector(1,nlc+1);
   }
 
   t = silminState->T;
@@ -209,12 +227,14 @@ int evaluateSaturationState(double *rSol, double *rLiq)
 
   } else {    /* liquid is absent */
 
-    double *muAllSol, **stoichMatrix, *muAllLiq, *w, **v;
-    char *yes;
-    int nonZero, m, n;
-    muAllSol = (double *) calloc((unsigned) npc, sizeof(double));
-    muAllLiq = dvector(1,nlc+1);
-    stoichMatrix = dmatrix(1,npc,1,nlc+1);
+    int m, n, refactor;
+
+    /* liquid components whose oxides are all in the system */
+    for (k=0,l=0;k<nlc;k++) {
+      for (n=0,liqCompPresent[k]=TRUE;n<nc;n++)
+        if (silminState->bulkComp[n] == 0.0 && liquid[k].liqToOx[n] != 0) liqCompPresent[k] = FALSE;
+      if (liqCompPresent[k]) l++;
+    }
 
     /* obtain solid chemical potentials */
     for (i=0,j=1;i<npc;i++) {
@@ -240,22 +260,12 @@ int evaluateSaturationState(double *rSol, double *rLiq)
       if (solids[i].type == PHASE) {
         if (silminState->nSolidCoexist[i]) {
           if (solids[i].na == 1) {
-            for (k=0,l=1;k<nlc;k++) {
-              for (n=0,nonZero=1;n<nc;n++)
-                if (silminState->bulkComp[n] == 0.0 && liquid[k].liqToOx[n] != 0) nonZero = 0;
-              if (nonZero)
-                stoichMatrix[j][l++] = solids[i].solToLiq[k];
-            }
+            for (k=0,m=1;k<nlc;k++) if (liqCompPresent[k]) stoichMatrix[j][m++] = solids[i].solToLiq[k];
             j++;
           } else {
-            for (m=0;m<solids[i].na;m++) {
-              if (silminState->solidComp[i+1+m][0] != 0.0) {
-                for (k=0,l=1;k<nlc;k++) {
-                  for (n=0,nonZero=1;n<nc;n++)
-                    if (silminState->bulkComp[n] == 0.0 && liquid[k].liqToOx[n] != 0) nonZero = 0;
-                  if (nonZero)
-                    stoichMatrix[j][l++] = solids[i+1+m].solToLiq[k];
-                }
+            for (n=0;n<solids[i].na;n++) {
+              if (silminState->solidComp[i+1+n][0] != 0.0) {
+                for (k=0,m=1;k<nlc;k++) if (liqCompPresent[k]) stoichMatrix[j][m++] = solids[i+1+n].solToLiq[k];
                 j++;
               }
             }
@@ -263,20 +273,34 @@ int evaluateSaturationState(double *rSol, double *rLiq)
         }
       }
     }
-    l-=1; j-=1; /* l now holds number of columns, j number of rows */
+    j-=1; /* l holds number of columns, j number of rows */
+
     /* obtain liquid chemical potentials by least squares; if solids are in
        equilibrium the system should be overdetermined but exactly consistent */
-    w = dvector(1,l);
-    v = dmatrix(1,l,1,l);
-    yes = (char *) malloc((unsigned) (j+1)*sizeof(char));
-    for (i=1; i<=j; i++) yes[i] = 1;
-    svdcmp(stoichMatrix,j,l,w,v);
-    for (i=1;i<l;i++) if (w[i] < 1.0e-08) w[i] = 0.0;
-    svbksb(stoichMatrix,w,v,j,l,muAllSol,yes,muAllLiq);
+    refactor = (j != stoichRows) || (l != stoichCols);
+    for (i=1;!refactor && (i<=j);i++) for (k=1;k<=l;k++) if (stoichMatrix[i][k] != stoichSVD[i][k]) { refactor = TRUE; break; }
+    if (refactor) {
+      for (i=1;i<=j;i++) for (k=1;k<=l;k++) stoichSVD[i][k] = u[i][k] = stoichMatrix[i][k];
+      stoichRows = j;
+      stoichCols = l;
+      svdcmp(u,j,l,w,v);
+      for (i=1;i<l;i++) if (w[i] < 1.0e-08) w[i] = 0.0;
+    }
+    for (k=1;k<=l;k++) {     /* back substitution, as svbksb() */
+      double s = 0.0;
+      if (w[k]) {
+        for (i=1;i<=j;i++) s += u[i][k]*muAllSol[i];
+        s /= w[k];
+      }
+      wInvUb[k] = s;
+    }
+    for (k=1;k<=l;k++) {
+      double s = 0.0;
+      for (m=1;m<=l;m++) s += v[k][m]*wInvUb[m];
+      muAllLiq[k] = s;
+    }
     for (i=0,l=1;i<nlc;i++) {
-      for (n=0,nonZero=1;n<nc;n++)
-        if (silminState->bulkComp[n] == 0.0 && liquid[i].liqToOx[n] != 0) nonZero = 0;
-      if (!nonZero) {
+      if (!liqCompPresent[i]) {
         muLiq[i] = 0.0;
         liquidComp[i] = 0.0;
       } else {
@@ -284,13 +308,6 @@ int evaluateSaturationState(double *rSol, double *rLiq)
         liquidComp[i] = 1.0;
       }
     }
-    l-=1;
-    free_dvector(w,1,l);
-    free_dmatrix(v,1,l,1,l);
-    free_dmatrix(stoichMatrix,1,npc,1,nlc+1);
-    free_dvector(muAllLiq,1,nlc+1);
-    free(muAllSol);
-    free(yes);
   }
 
   hasSupersat = FALSE;
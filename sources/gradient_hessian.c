@@ -101,6 +101,12 @@ MELTS Source Code: RCS
 **      arrays cMatrix, hVector, dVector and yVector must have been set in a 
 **      previous call to getEqualityConstraints()
 **
+**      getEquilibriumSensitivities()
+**
+**      Function to compute the derivatives of the converged state with
+**      respect to T, P and bulk composition, from the projected Hessian
+**      of that state (implicit function theorem)
+**
 **      (file: GRADIENT_HESSIAN.C)
 **
 **  MODIFICATION HISTORY:
@@ -165,6 +171,7 @@ MELTS Source Code: RCS
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <float.h>
 
 #ifndef BATCH_VERSION
 #include <Xm/Xm.h> 
@@ -213,11 +220,12 @@ void intenToExtenHessian(double pMix, double *dpMix, double **d2pMix,
 
 #define REALLOC(x, y) (((x) == NULL) ? malloc(y) : realloc((x), (y)))
 
+static int colRow = 0; /* rows of storage from the previous call; also a row index below */
+
 int getProjGradientAndHessian(int conRows, int conCols, double ***eMatrixPt, 
        double ***bMatrixPt, double **cMatrix, double *hVector, double *dVector, 
        double *yVector)
 {
-  static int colRow = 0;
   double **eMatrix = *eMatrixPt,
          **bMatrix = *bMatrixPt;
   double pMixLiq, *dpMixLiq, **d2pMixLiq, pMixSol, *dpMixSol, **d2pMixSol,
@@ -1412,5 +1420,244 @@ int getProjGradientAndHessian(int conRows, int conCols, double ***eMatrixPt,
   return hessianType;
 }
 
+/****************************************************************************
+   Sensitivities of a converged equilibrium state
+ ****************************************************************************/
+
+/* Steps used to difference the projected gradient; the step in bulk
+   composition is relative to the total moles of oxides in the system.      */
+#define SENSITIVITY_DELTA_T    1.0e-2
+#define SENSITIVITY_DELTA_P    1.0
+#define SENSITIVITY_DELTA_BULK 1.0e-6
+
+/* As at the CHANGE_TP step of silmin() */
+static void updateStandardStates(void)
+{
+  int i, j, k;
+
+  for (i=0; i<nlc; i++)
+    gibbs(silminState->T, silminState->P, (char *) liquid[i].label, &(liquid[i].ref), &(liquid[i].liq), &(liquid[i].fus), &(liquid[i].cur));
+  for (i=0, j=0; i<npc; i++) if (solids[i].type == PHASE) {
+    if ((silminState->incSolids)[j]) {
+      if (solids[i].na == 1) gibbs(silminState->T, silminState->P, (char *) solids[i].label, &(solids[i].ref), NULL, NULL, &(solids[i].cur));
+      else for (k=0; k<solids[i].na; k++)
+        gibbs(silminState->T, silminState->P, (char *) solids[i+1+k].label, &(solids[i+1+k].ref), NULL, NULL, &(solids[i+1+k].cur));
+    }
+    j++;
+  }
+  if (silminState->fo2Path != FO2_NONE) gibbs(silminState->T, silminState->P, "o2", &(oxygen.ref), NULL, NULL, &(oxygen.cur));
+}
+
+/* Redistributes Fe2O3 and FeO in each liquid to impose the buffer, as at the
+   CHANGE_TP step of silmin()                                               */
+static void imposeLiquidBuffer(void)
+{
+  double *moles = (double *) malloc((size_t) nc*sizeof(double));
+  int i, j, nl;
+
+  silminState->fo2 = getlog10fo2(silminState->T, silminState->P, silminState->fo2Path);
+  for (nl=0; nl<silminState->nLiquidCoexist; nl++) {
+    for (i=0; i<nc; i++) {
+      for (j=0, moles[i]=0.0; j<nlc; j++) moles[i] += (silminState->liquidComp)[nl][j]*(liquid[j].liqToOx)[i];
+      (silminState->bulkComp)[i] -= moles[i];
+    }
+    conLiq(FIRST | SEVENTH, FIRST, silminState->T, silminState->P, moles, NULL, NULL, NULL, NULL, NULL, &(silminState->fo2));
+    for (i=0; i<nc; i++) (silminState->bulkComp)[i] += moles[i];
+    for (i=0; i<nlc; i++) for (j=0, (silminState->liquidComp)[nl][i]=0.0; j<nc; j++) (silminState->liquidComp)[nl][i] += moles[j]*(bulkSystem[j].oxToLiq)[i];
+  }
+  free(moles);
+}
+
+/* Loads the variables of the quadratic problem, in the column order of
+   getEqualityConstraints(), into x[][col]; returns their number           */
+static int loadColumnVariables(double **x, int col)
+{
+  int i, k, nl, ns, j = 0;
+
+  if (silminState->liquidMass != 0.0) for (nl=0; nl<silminState->nLiquidCoexist; nl++)
+    for (i=0; i<nlc; i++) if ((silminState->liquidComp)[nl][i] != 0.0) x[j++][col] = (silminState->liquidComp)[nl][i];
+  for (i=0; i<npc; i++) for (ns=0; ns<(silminState->nSolidCoexist)[i]; ns++) {
+    if (solids[i].na == 1) x[j++][col] = (silminState->solidComp)[i][ns];
+    else for (k=0; k<solids[i].na; k++) if ((silminState->solidComp)[i+1+k][ns] != 0.0) x[j++][col] = (silminState->solidComp)[i+1+k][ns];
+  }
+  return j;
+}
+
+/****************************************************************************
+   getEquilibriumSensitivities()
+
+   First order sensitivities of the converged state in silminState by the
+   implicit function theorem.  Parameter 0 is T (K), parameter 1 is P (bars)
+   and parameter 2+i is the moles of oxide i in the bulk composition.  On
+   return dPhaseOx[k][j][i] is the derivative of the moles of oxide i in
+   phase k with respect to parameter j, where the phases are the coexisting
+   liquids followed by each solid phase present, in the order of solids[]
+   and then of coexistence.  The caller allocates dPhaseOx.
+
+   At the solution the quadratic step of silmin() vanishes.  The derivative
+   of the state is the derivative of that step with respect to a parameter,
+   i.e. the solution of the projected Hessian e22^ of the converged state for
+   the derivative of the right hand side b2^ (and of Y1^, the part fixed by
+   the constraints).  The derivatives of b2^ and Y1^ are obtained by central
+   differences of getProjGradientAndHessian() and getEqualityConstraints()
+   at perturbed T, P or bulk composition, without equilibration, and e22^
+   is factored once by HFTI for all parameters.  When the bulk composition
+   is not fixed by the constraints (an fO2 buffer) the oxide is added to the
+   liquid and the buffer imposed before the step is taken, as in silmin().
+   Oxides absent from the system are left with zero derivatives.
+
+   Returns FALSE, leaving dPhaseOx zero, if the state is isenthalpic,
+   isentropic or isochoric, or is buffered in fO2 without liquid, or if a
+   perturbation changes the structure of the problem, or, setting
+   *rankDeficient, if e22^ is rank deficient.  silminState and the standard
+   state properties are left as at entry.
+ ****************************************************************************/
+
+int getEquilibriumSensitivities(double ***dPhaseOx, int *rankDeficient)
+{
+  int isenthalpic = (silminState->refEnthalpy != 0.0) && silminState->isenthalpic;
+  int isentropic  = (silminState->refEntropy  != 0.0) && silminState->isentropic;
+  int isochoric   = (silminState->refVolume   != 0.0) && silminState->isochoric;
+  int hasLiquid   = (silminState->liquidMass  != 0.0);
+  int hasNlCon    = (silminState->fo2Path != FO2_NONE);
+  int nParams = 2 + nc, nPhases, colRowIn = colRow, success = TRUE;
+  int conRows0 = 0, conCols0 = 0, conRows = 0, conCols = 0, nz, pseudoRank = 0;
+  double **cMatrix0 = NULL, *hVector0 = NULL, *dVector0 = NULL, *yVector0 = NULL, **eMatrix0 = NULL, **bMatrix0 = NULL;
+  double **cMatrix  = NULL, *hVector  = NULL, *dVector  = NULL, *yVector  = NULL, **eMatrix  = NULL, **bMatrix  = NULL;
+  double **dxMatrix, **fxMatrix, **xMatrix, *z0, totalMoles;
+  SilminState *state0;
+  int i, j, k, l, m, n, nl, ns, side, eRows = 0;
+
+  for (i=0, nPhases=(hasLiquid ? silminState->nLiquidCoexist : 0); i<npc; i++) nPhases += (silminState->nSolidCoexist)[i];
+  *rankDeficient = FALSE;
+  for (k=0; k<nPhases; k++) for (j=0; j<nParams; j++) for (i=0; i<nc; i++) dPhaseOx[k][j][i] = 0.0;
+  if (isenthalpic || isentropic || isochoric || (hasNlCon && !hasLiquid)) return FALSE;
+
+  for (i=0, totalMoles=0.0; i<nc; i++) totalMoles += (silminState->bulkComp)[i];
+  state0 = copySilminStateStructure(silminState, NULL);
+  updateStandardStates();
+
+  /* Constraints, projected Hessian and gradient of the converged state */
+  colRow = 0;
+  getEqualityConstraints(&conRows0, &conCols0, &cMatrix0, &hVector0, &dVector0, &yVector0);
+  getProjGradientAndHessian(conRows0, conCols0, &eMatrix0, &bMatrix0, cMatrix0, hVector0, dVector0, yVector0);
+  nz = conCols0 - conRows0;
+
+  dxMatrix = matrix(0, conCols0-1, 0, nParams-1);
+  fxMatrix = matrix(0, conCols0-1, 0, nParams-1);
+  xMatrix  = matrix(0, conCols0-1, 0, 0);
+  z0       = vector(0, conCols0-1);
+  for (i=0; i<conCols0; i++) for (j=0; j<nParams; j++) dxMatrix[i][j] = fxMatrix[i][j] = 0.0;
+
+  /* Without an fO2 buffer the quadratic step is for the state itself, so
+     b2^ is taken relative to z0 = K2^^T x of the converged state            */
+  loadColumnVariables(xMatrix, 0);
+  for (i=0; i<conRows0; i++) householderRowCol(HOUSEHOLDER_CALC_MODE_H2, i, i+1, conCols0-1, cMatrix0, i, &hVector0[i], xMatrix, 0, 0);
+  for (i=conRows0; i<conCols0; i++) z0[i] = hasNlCon ? 0.0 : xMatrix[i][0];
+
+  /* Central differences of Y1^ and b2^, stored in the rows of dxMatrix, and of
+     the variables themselves where a perturbation moves them, in fxMatrix  */
+  for (j=0; (j<nParams) && success; j++) {
+    double delta;
+    if ((j >= 2) && ((silminState->bulkComp)[j-2] == 0.0)) continue;
+    delta = (j == 0) ? SENSITIVITY_DELTA_T : ((j == 1) ? SENSITIVITY_DELTA_P : SENSITIVITY_DELTA_BULK*totalMoles);
+
+    for (side=-1; (side<=1) && success; side+=2) {
+      silminState = copySilminStateStructure(state0, silminState);
+      if      (j == 0) silminState->T += side*delta;
+      else if (j == 1) silminState->P += side*delta;
+      else {
+        (silminState->bulkComp)[j-2] += side*delta;
+        if (hasNlCon) {
+          for (i=0; i<nlc; i++) (silminState->liquidComp)[0][i] += side*delta*(bulkSystem[j-2].oxToLiq)[i];
+          silminState->liquidMass += side*delta*bulkSystem[j-2].mw;
+        }
+      }
+      if (j < 2) updateStandardStates();
+      if (hasNlCon) imposeLiquidBuffer();
+
+      colRow = eRows;
+      getEqualityConstraints(&conRows, &conCols, &cMatrix, &hVector, &dVector, &yVector);
+      if ((conRows != conRows0) || (conCols != conCols0)) { success = FALSE; break; }
+      getProjGradientAndHessian(conRows, conCols, &eMatrix, &bMatrix, cMatrix, hVector, dVector, yVector);
+      eRows = conCols;
+
+      loadColumnVariables(xMatrix, 0);
+      for (i=0; i<conCols; i++) fxMatrix[i][j] += side*xMatrix[i][0]/(2.0*delta);
+      for (i=0; i<conRows; i++) dxMatrix[i][j] += side*yVector[i]/(2.0*delta);
+      for (i=conRows; i<conCols; i++) {
+        double b2 = bMatrix[i][0];
+        for (l=conRows; l<conCols; l++) b2 -= eMatrix[i][l]*z0[l];
+        dxMatrix[i][j] += side*b2/(2.0*delta);
+      }
+    }
+  }
+  silminState = copySilminStateStructure(state0, silminState);
+  destroySilminStateStructure(state0);
+  updateStandardStates();
+
+  /* Solve e22^ Z2 = b2^ for all parameters at once */
+  if (success && (nz > 0)) {
+    double **aMatrix = matrix(0, nz-1, 0, nz-1), *hWork = vector(0, nz-1), *gWork = vector(0, nz-1), *rNorm = vector(0, nParams-1);
+    double scale = DBL_MIN;
+    int *pWork = ivector(0, nz-1);
+
+    for (i=0; i<nz; i++) for (k=0; k<nz; k++) if (fabs(eMatrix0[conRows0+i][conRows0+k]) > scale) scale = fabs(eMatrix0[conRows0+i][conRows0+k]);
+    for (i=0; i<nz; i++) {
+      for (k=0; k<nz; k++) aMatrix[i][k] = eMatrix0[conRows0+i][conRows0+k]/scale;
+      for (j=0; j<nParams; j++) dxMatrix[conRows0+i][j] /= scale;
+    }
+    hfti(aMatrix, nz, nz, &dxMatrix[conRows0], nParams, 10.0*DBL_EPSILON, &pseudoRank, rNorm, hWork, gWork, pWork);
+    if (pseudoRank < nz) *rankDeficient = TRUE;
+
+    free_ivector(pWork, 0, nz-1);
+    free_vector(rNorm, 0, nParams-1);
+    free_vector(gWork, 0, nz-1);
+    free_vector(hWork, 0, nz-1);
+    free_matrix(aMatrix, 0, nz-1, 0, nz-1);
+  }
+
+  /* dx = K [ dY1^ ; dZ2 ] + the change made by the perturbation itself, summed
+     to the oxides of each phase                                            */
+  if (success && !(*rankDeficient)) {
+    for (i=(conRows0-1); i>=0; i--) householderRowCol(HOUSEHOLDER_CALC_MODE_H2, i, i+1, conCols0-1, cMatrix0, i, &hVector0[i], dxMatrix, 0, nParams-1);
+    for (i=0; i<conCols0; i++) for (j=0; j<nParams; j++) dxMatrix[i][j] += fxMatrix[i][j];
+
+    for (j=0; j<nParams; j++) {
+      l = 0; k = 0;
+      if (hasLiquid) for (nl=0; nl<silminState->nLiquidCoexist; nl++, k++)
+        for (m=0; m<nlc; m++) if ((silminState->liquidComp)[nl][m] != 0.0) {
+          for (i=0; i<nc; i++) dPhaseOx[k][j][i] += (liquid[m].liqToOx)[i]*dxMatrix[l][j];
+          l++;
+        }
+      for (m=0; m<npc; m++) for (ns=0; ns<(silminState->nSolidCoexist)[m]; ns++, k++) {
+        if (solids[m].na == 1) {
+          for (i=0; i<nc; i++) dPhaseOx[k][j][i] += (solids[m].solToOx)[i]*dxMatrix[l][j];
+          l++;
+        } else for (n=0; n<solids[m].na; n++) if ((silminState->solidComp)[m+1+n][ns] != 0.0) {
+          for (i=0; i<nc; i++) dPhaseOx[k][j][i] += (solids[m+1+n].solToOx)[i]*dxMatrix[l][j];
+          l++;
+        }
+      }
+    }
+  }
+
+  free_vector(z0, 0, conCols0-1);
+  free_matrix(xMatrix, 0, conCols0-1, 0, 0);
+  free_matrix(fxMatrix, 0, conCols0-1, 0, nParams-1);
+  free_matrix(dxMatrix, 0, conCols0-1, 0, nParams-1);
+  for (i=0; i<conCols0; i++) { free(eMatrix0[i]); free(bMatrix0[i]); }
+  free(eMatrix0); free(bMatrix0);
+  for (i=0; i<eRows; i++) { free(eMatrix[i]); free(bMatrix[i]); }
+  free(eMatrix); free(bMatrix);
+  for (i=0; i<conRows0; i++) free(cMatrix0[i]);
+  free(cMatrix0); free(hVector0); free(dVector0); free(yVector0);
+  for (i=0; i<conRows; i++) free(cMatrix[i]);
+  free(cMatrix); free(hVector); free(dVector); free(yVector);
+  colRow = colRowIn;
+
+  return success && !(*rankDeficient);
+}
+
 /* end of file GRADIENT_HESSIAN.C */
 
@@ -168,6 +168,11 @@ const char *interface_ver(void) { return "$Id: interface.c,v 1.13 2009/05/14 04:
 #define DIR_DELIM "\\"
 #else
 #define DIR_DELIM "/"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #endif
 #endif
 
@@ -358,6 +363,20 @@ getCommandLineAndEnvironment (int argc, char *argv[])
 #define REALLOC(x, y) (((x) == NULL) ? malloc(y) : realloc((x), (y)))
 #define REC 134
 
+/* In server mode the MELTSinput document is taken from serverRequest rather
+   than read from a file, and the MELTSoutput and MELTSstatus documents are
+   written to serverReply rather than to files.                              */
+
+static const char  *serverRequest       = NULL;
+static int          serverRequestLength = 0;
+static xmlBufferPtr serverReply         = NULL;
+
+static xmlTextWriterPtr newXmlWriter(char *fileName)
+{
+    if (serverReply != NULL) return xmlNewTextWriterMemory(serverReply, 0);
+    return xmlNewTextWriterFilename(fileName, 0);
+}
+
 /* returns TRUE if successful */
 /*         FALSE if not       */
 
@@ -542,8 +561,20 @@ static int batchInputDataFromFile(char *fileName)
             else if (!strncmp(&line[6],  "isenthalpic",	  MIN((len-6), 11))) silminState->isenthalpic	 = TRUE;
             else if (!strncmp(&line[6],  "isentropic",	  MIN((len-6), 10))) silminState->isentropic	 = TRUE;
             else if (!strncmp(&line[6],  "isochoric", 	  MIN((len-6),  9))) silminState->isochoric	 = TRUE;
+            else if (!strncmp(&line[6],  "adaptive steps",      MIN((len-6), 14))) meltsStepControl.adaptive  = TRUE;
             else { return FALSE; }
 
+            /* -> adaptive step records (multiples of the increments, % of system mass) */
+        } else if (!strncmp(line, "minimum step: ",          MIN(len,14))) {
+            if (sscanf(&line[14], "%f", &temporary) == EOF || temporary <= 0.0) { return FALSE; }
+            meltsStepControl.minScale = (double) temporary;
+        } else if (!strncmp(line, "maximum step: ",          MIN(len,14))) {
+            if (sscanf(&line[14], "%f", &temporary) == EOF || temporary <= 0.0) { return FALSE; }
+            meltsStepControl.maxScale = (double) temporary;
+        } else if (!strncmp(line, "maximum liquid change: ", MIN(len,23))) {
+            if (sscanf(&line[23], "%f", &temporary) == EOF || temporary <= 0.0) { return FALSE; }
+            meltsStepControl.maxChange = (double) temporary/100.0;
+
             /* -> assimilate a solid phase record */
         } else if (!strncmp(line, "assimilant: ",            MIN(len,12))) {
 
@@ -676,8 +707,13 @@ static void SelectComputeDataStruct(void) {
 
 #define RETURN_FINALIZED        6
 
+/* The schema is parsed on the first call and kept.  libxml2 is deliberately
+   not cleaned up on return: the -sequence.xml writer stays open from one
+   call to the next in listener and server mode, and xmlCleanupParser()
+   releases global state that it still uses.                                 */
+
 static int batchInputDataFromXmlFile(char *fileName) {
-    xmlSchemaPtr schema = NULL;
+    static xmlSchemaPtr schema = NULL;
     xmlSchemaParserCtxtPtr ctxt = NULL;
     xmlSchemaValidCtxtPtr ctxt2 = NULL;
     int ret = TRUE;
@@ -687,11 +723,13 @@ static int batchInputDataFromXmlFile(char *fileName) {
     silminInputData.name = (char *) malloc((size_t) (strlen(fileName)+1)*sizeof(char));
     (void) strcpy(silminInputData.name, fileName);
 
-    ctxt = xmlSchemaNewParserCtxt("MELTSinput.xsd");
-    xmlSchemaSetParserErrors(ctxt,(xmlSchemaValidityErrorFunc) fprintf, (xmlSchemaValidityWarningFunc) fprintf, stderr);
+    if (schema == NULL) {
+        ctxt = xmlSchemaNewParserCtxt("MELTSinput.xsd");
+        xmlSchemaSetParserErrors(ctxt,(xmlSchemaValidityErrorFunc) fprintf, (xmlSchemaValidityWarningFunc) fprintf, stderr);
 
-    schema = xmlSchemaParse(ctxt);
-    xmlSchemaFreeParserCtxt(ctxt);
+        schema = xmlSchemaParse(ctxt);
+        xmlSchemaFreeParserCtxt(ctxt);
+    }
 
     if (schema != NULL) {
         xmlDocPtr doc = NULL;
@@ -699,7 +737,8 @@ static int batchInputDataFromXmlFile(char *fileName) {
         ctxt2 = xmlSchemaNewValidCtxt(schema);
         xmlSchemaSetValidErrors(ctxt2,(xmlSchemaValidityErrorFunc) fprintf,(xmlSchemaValidityWarningFunc) fprintf, stderr);
 
-        doc = xmlReadFile(fileName, NULL, 0);
+        if (serverRequest != NULL) doc = xmlReadMemory(serverRequest, serverRequestLength, fileName, NULL, 0);
+        else                       doc = xmlReadFile(fileName, NULL, 0);
         if (doc) {
             if (xmlSchemaValidateDoc(ctxt2, doc)) {
                 printf("File %s is invalid against schema MELTSinput.xsd.\n", fileName);
@@ -718,8 +757,18 @@ static int batchInputDataFromXmlFile(char *fileName) {
                             int i, j, np;
                             printf("Found initialize: %s\n", content1);
 
-                            if (silminState != NULL)
-                                ; /*destroy the old state - nyi */
+                            if (silminState != NULL) { /* start from a new state, as a new process would */
+                                if (silminState->fracSComp != NULL) {
+                                    for (i=0; i<npc; i++) free((silminState->fracSComp)[i]);
+                                    free(silminState->fracSComp);
+                                    free(silminState->nFracCoexist);
+                                }
+                                free(silminState->fracLComp);
+                                free(silminState->ySol);
+                                free(silminState->yLiq);
+                                destroySilminStateStructure(silminState);
+                                silminState = NULL;
+                            }
                             if (silminState == NULL) { // add test to avoid memory leak
                                 silminState = allocSilminStatePointer();
                                 for (i=0, np=0; i<npc; i++) if (solids[i].type == PHASE) { (silminState->incSolids)[np] = TRUE; np++; }
@@ -1404,10 +1453,6 @@ static int batchInputDataFromXmlFile(char *fileName) {
         ret = FALSE;
     }
 
-    if (schema != NULL) xmlSchemaFree(schema);
-    xmlSchemaCleanupTypes();
-    xmlCleanupParser();
-
     return ret;
 }
 
@@ -1434,7 +1479,7 @@ static void putOutputDataToXmlFile(char *outputFile) {
     len = strlen(cOut);
     cOut[len-1] = '\0';
 
-    writer = xmlNewTextWriterFilename(outputFile, 0);
+    writer = newXmlWriter(outputFile);
     rc = xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL);
 
     rc = xmlTextWriterStartElement(writer, BAD_CAST "MELTSoutput");
@@ -2133,7 +2178,7 @@ static void putStatusDataToXmlFile(char *statusFile) {
 
     printf("Output file name is %s\n", statusFile);
 
-    writer = xmlNewTextWriterFilename(statusFile, 0);
+    writer = newXmlWriter(statusFile);
     rc = xmlTextWriterStartDocument(writer, NULL, "UTF-8", NULL);
     rc = xmlTextWriterWriteFormatElement(writer, BAD_CAST "MELTSstatus", "%s", m[meltsStatus.status]);
     rc = xmlTextWriterEndDocument(writer);
@@ -2354,6 +2399,1277 @@ static void doBatchFractionation(void) {
     }
 }
 
+/* Processes one MELTSinput document held in memory and writes the MELTSoutput
+   and MELTSstatus documents into output and status.  The output document is
+   left empty if the input could not be processed or requested no calculation.
+   Used by the server and stream modes, which keep the system state from one
+   document to the next as listener mode does.                               */
+
+static void processXmlRequest(char *request, int len, xmlBufferPtr output, xmlBufferPtr status)
+{
+    char name[] = "server.xml";
+    int ret;
+
+    if (silminState == NULL) {
+        int i, np;
+        silminState = allocSilminStatePointer();
+        for (i=0, np=0; i<npc; i++) if (solids[i].type == PHASE) { (silminState->incSolids)[np] = TRUE; np++; }
+        (silminState->incSolids)[npc] = TRUE;
+        silminState->nLiquidCoexist  = 1;
+        silminState->fo2Path  = FO2_NONE;
+    }
+    silminState->assimilate = FALSE;
+
+    serverRequest       = request;
+    serverRequestLength = len;
+    ret = batchInputDataFromXmlFile(name);
+    serverRequest       = NULL;
+    if (ret != FALSE) previousSilminState = copySilminStateStructure(silminState, previousSilminState);
+
+    serverReply = output;
+
+    if        (ret == FALSE) {
+        meltsStatus.status = GENERIC_INTERNAL_ERROR;
+    } else if (ret == RUN_LIQUIDUS_CALC) {
+        meltsStatus.status = GENERIC_INTERNAL_ERROR;
+        while(!liquidus());
+        putOutputDataToXmlFile(name);
+    } else if (ret == RUN_EQUILIBRATE_CALC) {
+        meltsStatus.status = GENERIC_INTERNAL_ERROR;
+        while(!silmin());
+        putOutputDataToXmlFile(name);
+    } else if (ret == RETURN_WITHOUT_CALC) {
+        meltsStatus.status = SILMIN_SUCCESS;
+        putOutputDataToXmlFile(name);
+    } else if (ret == RETURN_DO_FRACTIONATION) {
+        doBatchFractionation();
+        meltsStatus.status = SILMIN_SUCCESS;
+        putOutputDataToXmlFile(name);
+    } else if (ret == RETURN_FINALIZED) {
+        meltsStatus.status = SILMIN_SUCCESS;
+        putSequenceDataToXmlFile(FALSE); /* finalize and close file */
+    }
+
+    serverReply = status;
+    putStatusDataToXmlFile(name);
+    serverReply = NULL;
+}
+
+/* Stream mode.  The input is any number of MELTSinput documents written one
+   after the other (which is not itself a well formed XML document, so it is
+   split at each closing </MELTSinput> tag).  The input is read with read(2),
+   which returns whatever has arrived, so each document is processed as soon
+   as its closing tag is in; the input may be a pipe fed by another program
+   that waits for the reply.  The MELTSoutput and MELTSstatus documents are
+   appended to the output file.                                              */
+
+static void batchStream(char *inputFile, char *outputFile)
+{
+    static const char endTag[] = "</MELTSinput>";
+    FILE *input, *output;
+    char *buffer = NULL;
+    size_t size = 0, used = 0, searched = 0;
+    ssize_t nRead;
+    int nDocs = 0;
+
+    if (!strcmp(inputFile, "-")) input = stdin;
+    else if ((input = fopen(inputFile, "r")) == NULL) {
+        printf("Error(s) detected on opening input file %s. Exiting.\n", inputFile); exit(0);
+    }
+    if ((output = fopen(outputFile, "w")) == NULL) {
+        printf("Error(s) detected on opening output file %s. Exiting.\n", outputFile); exit(0);
+    }
+
+    for (;;) {
+        char *end;
+
+        if (size - used < BUFSIZ + 1) {
+            size = 2*size + BUFSIZ + 1;
+            buffer = (char *) REALLOC(buffer, size*sizeof(char));
+            buffer[used] = '\0'; /* the input may end before anything is read */
+        }
+        nRead = read(fileno(input), &buffer[used], size - used - 1);
+        if ((nRead < 0) && (errno == EINTR)) continue;
+        if (nRead <= 0) break;
+        used += (size_t) nRead;
+        buffer[used] = '\0';
+
+        /* a tag split between reads starts in the last strlen(endTag)-1 bytes searched */
+        while ((end = strstr(&buffer[searched], endTag)) != NULL) {
+            xmlBufferPtr docOutput = xmlBufferCreate();
+            xmlBufferPtr docStatus = xmlBufferCreate();
+            size_t start = strspn(buffer, " \t\r\n"); /* the XML declaration must come first */
+            size_t len = (size_t) (end - buffer) + strlen(endTag);
+            char next = buffer[len];
+
+            buffer[len] = '\0';
+            processXmlRequest(&buffer[start], (int) (len - start), docOutput, docStatus);
+            buffer[len] = next;
+            nDocs++;
+
+            if (xmlBufferLength(docOutput) > 0) (void) fwrite(xmlBufferContent(docOutput), 1, (size_t) xmlBufferLength(docOutput), output);
+            (void) fwrite(xmlBufferContent(docStatus), 1, (size_t) xmlBufferLength(docStatus), output);
+            (void) fflush(output);
+            xmlBufferFree(docOutput);
+            xmlBufferFree(docStatus);
+
+            used -= len;
+            (void) memmove(buffer, &buffer[len], used+1);
+            searched = 0;
+        }
+        searched = (used < strlen(endTag)) ? 0 : used - strlen(endTag) + 1;
+    }
+    if (nRead < 0) printf("Error reading %s: %s.\n", inputFile, strerror(errno));
+
+    if (strspn(buffer, " \t\r\n") != used) printf("Incomplete MELTSinput document at end of %s ignored.\n", inputFile);
+    printf("Processed %d MELTSinput document(s) from %s.\n", nDocs, inputFile);
+
+    if (input != stdin) fclose(input);
+    fclose(output);
+    free(buffer);
+}
+
+#ifndef MINGW
+
+/* Server mode.  Each request is a MELTSinput document preceded by its length
+   in bytes, written as a decimal number on a line of its own.  Requests are
+   answered in order with the MELTSoutput document followed by the MELTSstatus
+   document, each framed the same way (see processXmlRequest()).  A client may
+   therefore send several requests before reading the replies.  One client is
+   served at a time.                                                         */
+
+static int writeServerReply(FILE *out, xmlBufferPtr buffer)
+{
+    int len = xmlBufferLength(buffer);
+
+    if (fprintf(out, "%d\n", len) < 0) return FALSE;
+    if ((len > 0) && (fwrite(xmlBufferContent(buffer), 1, (size_t) len, out) != (size_t) len)) return FALSE;
+    return TRUE;
+}
+
+static void serveConnection(FILE *in, FILE *out)
+{
+    static char *request = NULL;
+    static size_t requestSize = 0;
+    char header[REC];
+
+    for (;;) {
+        xmlBufferPtr output, status;
+        char *end;
+        long len;
+        int ok;
+
+        if (fgets(header, REC, in) == NULL) break;
+        len = strtol(header, &end, 10);
+        if ((end == header) || (len <= 0) || (len >= INT_MAX)) {
+            printf("Invalid request header in server mode.  Closing connection.\n");
+            break;
+        }
+        if ((size_t) len >= requestSize) {
+            requestSize = (size_t) len + 1;
+            request = (char *) REALLOC(request, requestSize*sizeof(char));
+        }
+        if (fread(request, 1, (size_t) len, in) != (size_t) len) break;
+        request[len] = '\0';
+
+        output = xmlBufferCreate();
+        status = xmlBufferCreate();
+        processXmlRequest(request, (int) len, output, status);
+
+        ok = writeServerReply(out, output) && writeServerReply(out, status) && (fflush(out) == 0);
+        xmlBufferFree(output);
+        xmlBufferFree(status);
+        if (!ok) break;
+    }
+}
+
+/* Listens on the Unix domain socket socketPath, or on the loopback TCP port
+   if port is non-zero.  Does not return.                                    */
+
+static void batchServer(char *socketPath, int port)
+{
+    int listenFd;
+
+    if (port > 0) {
+        struct sockaddr_in addr;
+        int on = 1;
+
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        (void) setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        (void) memset(&addr, 0, sizeof(addr));
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons((unsigned short) port);
+        if ((listenFd < 0) || bind(listenFd, (struct sockaddr *) &addr, sizeof(addr)) || listen(listenFd, 1)) {
+            printf("Cannot listen on port %d.  Exiting ...\n", port); exit(0);
+        }
+        printf("Batch melts is in server mode on loopback port %d\n", port);
+    } else {
+        struct sockaddr_un addr;
+
+        if (strlen(socketPath) >= sizeof(addr.sun_path)) { printf("Socket name %s is too long.  Exiting ...\n", socketPath); exit(0); }
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        (void) memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        (void) strcpy(addr.sun_path, socketPath);
+        (void) unlink(socketPath);
+        if ((listenFd < 0) || bind(listenFd, (struct sockaddr *) &addr, sizeof(addr)) || listen(listenFd, 1)) {
+            printf("Cannot listen on socket %s.  Exiting ...\n", socketPath); exit(0);
+        }
+        printf("Batch melts is in server mode on socket %s\n", socketPath);
+    }
+
+    /* a client that goes away shows up as a failed write, not a signal */
+    (void) signal(SIGPIPE, SIG_IGN);
+
+    for (;;) {
+        FILE *in, *out;
+        int fd = accept(listenFd, NULL, NULL);
+
+        if (fd < 0) {
+            if (errno != EINTR) printf("Error(s) detected on accepting a connection (%s).\n", strerror(errno));
+            continue;
+        }
+        in  = fdopen(fd, "r");
+        out = fdopen(dup(fd), "w");
+        if ((in != NULL) && (out != NULL)) serveConnection(in, out);
+        if (in  != NULL) fclose(in);  else close(fd);
+        if (out != NULL) fclose(out);
+    }
+}
+
+#endif /* MINGW */
+
+#ifndef MINGW
+
+/* Ensemble mode.  Runs perturbed copies (members) of one .melts input and
+   writes, for each step of the path, summary statistics over the members of
+   the phase proportions and the liquid composition.  The input is read and
+   the model initialized once; members are run by worker processes forked
+   from that image, since silmin() keeps its state in process globals.  Each
+   member draws its perturbations from a generator seeded by the member
+   number, so the results do not depend on the number of workers.
+
+   The perturbation file holds records in the style of a .melts file:
+     Members: 200
+     Workers: 8                          (default: number of processors)
+     Seed: 1
+     Relative Composition Error: 1.0     (1 sigma, % of each oxide)
+     Composition Error: SiO2 0.3         (1 sigma, wt %)
+     Log fO2 Error: 0.2                  (1 sigma, log units)
+     Pressure Error: 100                 (1 sigma, bars)                   */
+
+typedef struct _ensembleRecord {
+    int member;
+    int step;      /* -1 once the member has finished                        */
+    int status;    /* meltsStatus.status of a finished member                */
+} EnsembleRecord;
+
+static int ensembleMembers = 0, ensembleWorkers = 0, ensembleMember, ensembleStep, ensembleFd;
+static long ensembleSeed = 1;
+static double ensembleRelError = 0.0, ensembleFo2Error = 0.0, ensemblePError = 0.0, *ensembleOxError;
+static int ensembleNPhases, *ensemblePhase, ensembleNValues;
+static double *ensembleValues;
+
+/* Values reported for each step: T (C), P (bars), wt % of the system in each
+   phase (liquid first), liquid wt % oxides (zero if no liquid)             */
+#define ENSEMBLE_T       0
+#define ENSEMBLE_P       1
+#define ENSEMBLE_PHASE   2
+#define ENSEMBLE_LIQUID  (2+ensembleNPhases)
+
+static int readEnsembleFile(char *fileName)
+{
+    FILE *input;
+    char line[REC], label[REC];
+    size_t len;
+    int i, j;
+    float temporary;
+
+    if ((input = fopen(fileName, "r")) == NULL) {
+        printf("Error in ensemble input procedure. Cannot open file: %s\n", fileName);
+        return FALSE;
+    }
+    ensembleOxError = (double *) calloc((size_t) nc, sizeof(double));
+    ensembleWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    while (fgets(line, REC, input) != NULL) {
+        len = strlen(line); for (i=0; i<(int) len; i++) line[i] = tolower(line[i]);
+        if (strspn(line, " \t\r\n") == len) continue;
+
+        if        (!strncmp(line, "members: ",                    9)) {
+            if (sscanf(&line[9],  "%d", &ensembleMembers) != 1) { fclose(input); return FALSE; }
+        } else if (!strncmp(line, "workers: ",                    9)) {
+            if (sscanf(&line[9],  "%d", &ensembleWorkers) != 1) { fclose(input); return FALSE; }
+        } else if (!strncmp(line, "seed: ",                       6)) {
+            if (sscanf(&line[6],  "%ld", &ensembleSeed) != 1)   { fclose(input); return FALSE; }
+        } else if (!strncmp(line, "relative composition error: ", 28)) {
+            if (sscanf(&line[28], "%f", &temporary) != 1)       { fclose(input); return FALSE; }
+            ensembleRelError = (double) temporary/100.0;
+        } else if (!strncmp(line, "composition error: ",          19)) {
+            for (i=0; i<nc; i++) {
+                for (j=0; j < ((int) strlen(bulkSystem[i].label)); j++) label[j] = tolower((bulkSystem[i].label)[j]);
+                label[j] = '\0';
+                if (!strncmp(&line[19], label, strlen(label)) && (line[19+strlen(label)] == ' ')) {
+                    if (sscanf(&line[19 + strlen(label)], "%f", &temporary) != 1) { fclose(input); return FALSE; }
+                    ensembleOxError[i] = (double) temporary;
+                    break;
+                }
+            }
+            if (i == nc) { fclose(input); return FALSE; }
+        } else if (!strncmp(line, "log fo2 error: ",              15)) {
+            if (sscanf(&line[15], "%f", &temporary) != 1)       { fclose(input); return FALSE; }
+            ensembleFo2Error = (double) temporary;
+        } else if (!strncmp(line, "pressure error: ",             16)) {
+            if (sscanf(&line[16], "%f", &temporary) != 1)       { fclose(input); return FALSE; }
+            ensemblePError = (double) temporary;
+        } else {
+            fclose(input);
+            return FALSE;
+        }
+    }
+    fclose(input);
+
+    if (ensembleMembers < 1) return FALSE;
+    if (ensembleWorkers < 1) ensembleWorkers = 1;
+    return TRUE;
+}
+
+/* xorshift64* generator; the state must be non-zero */
+static double ensembleUniform(unsigned long long *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return (double) ((*state * 2685821657736338717ULL) >> 11)/9007199254740992.0;
+}
+
+static double ensembleNormal(unsigned long long *state)
+{
+    double u1 = ensembleUniform(state), u2 = ensembleUniform(state);
+    return sqrt(-2.0*log(1.0 - u1))*cos(2.0*3.14159265358979323846*u2);
+}
+
+static void perturbMember(SilminState *base, int member)
+{
+    unsigned long long state;
+    double dP;
+    int i, j;
+
+    state = 0x9e3779b97f4a7c15ULL*((unsigned long long) ensembleSeed) ^ (0xbf58476d1ce4e5b9ULL*((unsigned long long) member + 1));
+    if (state == 0) state = 1;
+    for (i=0; i<8; i++) (void) ensembleUniform(&state);
+
+    for (i=0, silminState->liquidMass=0.0; i<nc; i++) {
+        double wt = (base->bulkComp)[i]*bulkSystem[i].mw;
+        if (wt > 0.0) {
+            wt *= 1.0 + ensembleRelError*ensembleNormal(&state);
+            wt += ensembleOxError[i]*ensembleNormal(&state);
+            if (wt < 0.0) wt = 0.0;
+        }
+        (silminState->bulkComp)[i] = wt/bulkSystem[i].mw;
+        silminState->liquidMass   += wt;
+    }
+    for (i=0; i<nlc; i++)
+        for ((silminState->liquidComp)[0][i]=0.0, silminState->oxygen=0.0, j=0; j<nc; j++) {
+            (silminState->liquidComp)[0][i] += (silminState->bulkComp)[j]*(bulkSystem[j].oxToLiq)[i];
+            silminState->oxygen += (silminState->bulkComp)[j]*(bulkSystem[j].oxToLiq)[i]*(oxygen.liqToOx)[i];
+        }
+
+    silminState->fo2Delta += ensembleFo2Error*ensembleNormal(&state);
+
+    dP = ensemblePError*ensembleNormal(&state);
+    if (silminState->P + dP < 1.0) dP = 1.0 - silminState->P;
+    silminState->P         += dP;
+    silminState->dspPstart += dP;
+    if (silminState->dspPstop != 0.0) silminState->dspPstop = MAX(silminState->dspPstop + dP, 1.0);
+}
+
+static int writeFully(int fd, void *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size) {
+        ssize_t m = write(fd, (char *) buffer + n, size - n);
+        if (m <= 0) return FALSE;
+        n += (size_t) m;
+    }
+    return TRUE;
+}
+
+static int readFully(int fd, void *buffer, size_t size)
+{
+    size_t n = 0;
+    while (n < size) {
+        ssize_t m = read(fd, (char *) buffer + n, size - n);
+        if (m <= 0) return FALSE;
+        n += (size_t) m;
+    }
+    return TRUE;
+}
+
+/* Called by silmin() with each converged assemblage of a member's path */
+static void ensembleStepOutput(void)
+{
+    EnsembleRecord record;
+    double total = silminState->liquidMass, liquidTotal = 0.0;
+    int i, j, k, nl, ns;
+
+    for (k=0; k<ensembleNValues; k++) ensembleValues[k] = 0.0;
+    ensembleValues[ENSEMBLE_T] = silminState->T - 273.15;
+    ensembleValues[ENSEMBLE_P] = silminState->P;
+
+    for (nl=0; nl<silminState->nLiquidCoexist; nl++) for (i=0; i<nlc; i++) for (j=0; j<nc; j++)
+        ensembleValues[ENSEMBLE_LIQUID+j] += (silminState->liquidComp)[nl][i]*(liquid[i].liqToOx)[j]*bulkSystem[j].mw;
+    for (j=0; j<nc; j++) liquidTotal += ensembleValues[ENSEMBLE_LIQUID+j];
+    if (liquidTotal > 0.0) for (j=0; j<nc; j++) ensembleValues[ENSEMBLE_LIQUID+j] *= 100.0/liquidTotal;
+    ensembleValues[ENSEMBLE_PHASE] = silminState->liquidMass;
+
+    for (k=1; k<ensembleNPhases; k++) {
+        i = ensemblePhase[k];
+        for (ns=0; ns<(silminState->nSolidCoexist)[i]; ns++) {
+            if (solids[i].na == 1) {
+                for (j=0; j<nc; j++) ensembleValues[ENSEMBLE_PHASE+k] += (silminState->solidComp)[i][ns]*(solids[i].solToOx)[j]*bulkSystem[j].mw;
+            } else {
+                int a;
+                for (a=0; a<solids[i].na; a++) for (j=0; j<nc; j++)
+                    ensembleValues[ENSEMBLE_PHASE+k] += (silminState->solidComp)[i+1+a][ns]*(solids[i+1+a].solToOx)[j]*bulkSystem[j].mw;
+            }
+        }
+        total += ensembleValues[ENSEMBLE_PHASE+k];
+    }
+    if (total > 0.0) for (k=0; k<ensembleNPhases; k++) ensembleValues[ENSEMBLE_PHASE+k] *= 100.0/total;
+
+    record.member = ensembleMember;
+    record.step   = ensembleStep++;
+    record.status = 0;
+    if (!writeFully(ensembleFd, &record, sizeof(EnsembleRecord))
+        || !writeFully(ensembleFd, ensembleValues, (size_t) ensembleNValues*sizeof(double))) _exit(1);
+}
+
+static void ensembleWorker(SilminState *base, int taskFd, int resultFd)
+{
+    EnsembleRecord record;
+    int member;
+
+    (void) freopen("/dev/null", "w", stdout);
+    (void) freopen("/dev/null", "w", stderr);
+    ensembleFd      = resultFd;
+    meltsStepOutput = ensembleStepOutput;
+
+    while (readFully(taskFd, &member, sizeof(int)) && (member >= 0)) {
+        silminState = copySilminStateStructure(base, NULL);
+        perturbMember(base, member);
+        if ((silminState->fractionateSol || silminState->fractionateFlu) && silminState->fracSComp == (double **) NULL) {
+            silminState->fracSComp    = (double **) calloc((unsigned) npc, sizeof(double *));
+            silminState->nFracCoexist = (int *) calloc((unsigned) npc, sizeof(int));
+        }
+        if (silminState->fractionateLiq && silminState->fracLComp == (double *) NULL) {
+            silminState->fracLComp = (double *) calloc((unsigned) nlc, sizeof(double));
+        }
+
+        ensembleMember = member;
+        ensembleStep   = 0;
+        meltsStatus.status = GENERIC_INTERNAL_ERROR;
+        while(!silmin());
+
+        record.member = member;
+        record.step   = -1;
+        record.status = meltsStatus.status;
+        if (!writeFully(resultFd, &record, sizeof(EnsembleRecord))) break;
+        destroySilminStateStructure(silminState);
+        silminState = NULL;
+    }
+    _exit(0);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *((const double *) a), y = *((const double *) b);
+    return (x < y) ? -1 : ((x > y) ? 1 : 0);
+}
+
+static double quantile(double *sorted, int n, double q)
+{
+    double x = q*(n-1);
+    int i = (int) floor(x);
+    return (i+1 < n) ? sorted[i] + (x-i)*(sorted[i+1]-sorted[i]) : sorted[n-1];
+}
+
+static void putEnsembleStatistic(FILE *output, int step, double t, double p, const char *name, double *v, int n)
+{
+    double mean = 0.0, var = 0.0;
+    int i;
+
+    if (n == 0) return;
+    for (i=0; i<n; i++) mean += v[i];
+    mean /= n;
+    for (i=0; i<n; i++) var += (v[i]-mean)*(v[i]-mean);
+    var = (n > 1) ? var/(n-1) : 0.0;
+    qsort(v, (size_t) n, sizeof(double), compareDoubles);
+    fprintf(output, "%d,%.2f,%.1f,%s wt %%,%d,%g,%g,%g,%g,%g,%g,%g\n", step, t, p, name, n, mean, sqrt(var),
+            quantile(v, n, 0.05), quantile(v, n, 0.25), quantile(v, n, 0.50), quantile(v, n, 0.75), quantile(v, n, 0.95));
+}
+
+/* Statistics over the members that reached the step.  Phase proportions
+   count a member without the phase as zero; the liquid composition is over
+   the members with liquid.                                                  */
+static void putEnsembleStep(FILE *output, int step, double *values, int *reported)
+{
+    double *v = (double *) malloc((size_t) ensembleMembers*sizeof(double)), t = 0.0, p = 0.0;
+    char quantity[REC];
+    int k, m, n, nLiquid;
+
+    for (m=0, n=0; m<ensembleMembers; m++) if (reported[m]) {
+        t += values[m*ensembleNValues+ENSEMBLE_T];
+        p += values[m*ensembleNValues+ENSEMBLE_P];
+        n++;
+    }
+    if (n == 0) { free(v); return; }
+    t /= n; p /= n;
+
+    for (k=0; k<ensembleNPhases; k++) {
+        int present = FALSE;
+        for (m=0, n=0; m<ensembleMembers; m++) if (reported[m]) {
+            v[n] = values[m*ensembleNValues+ENSEMBLE_PHASE+k];
+            if (v[n++] > 0.0) present = TRUE;
+        }
+        if (present) putEnsembleStatistic(output, step, t, p, (k == 0) ? "liquid" : solids[ensemblePhase[k]].label, v, n);
+    }
+    for (k=0; k<nc; k++) {
+        int present = FALSE;
+        for (m=0, nLiquid=0; m<ensembleMembers; m++) if (reported[m] && (values[m*ensembleNValues+ENSEMBLE_PHASE] > 0.0)) {
+            v[nLiquid] = values[m*ensembleNValues+ENSEMBLE_LIQUID+k];
+            if (v[nLiquid++] > 0.0) present = TRUE;
+        }
+        if (present) {
+            (void) sprintf(quantity, "liquid %s", bulkSystem[k].label);
+            putEnsembleStatistic(output, step, t, p, quantity, v, nLiquid);
+        }
+    }
+    (void) fflush(output);
+    free(v);
+}
+
+typedef struct _ensembleWorkerProcess {
+    pid_t pid;
+    int   taskFd;
+    int   resultFd;
+    int   member;      /* member in progress, -1 if idle                     */
+} EnsembleWorkerProcess;
+
+static void startEnsembleWorker(SilminState *base, EnsembleWorkerProcess *worker, EnsembleWorkerProcess *pool)
+{
+    int toWorker[2], toParent[2], i;
+
+    if ((pipe(toWorker) != 0) || (pipe(toParent) != 0)) { printf("Cannot create pipes for ensemble workers.  Exiting ...\n"); exit(0); }
+    (void) fflush(stdout);
+    if ((worker->pid = fork()) < 0) { printf("Cannot fork ensemble workers.  Exiting ...\n"); exit(0); }
+    if (worker->pid == 0) {
+        for (i=0; i<ensembleWorkers; i++) if ((pool+i != worker) && (pool[i].pid > 0)) {
+            close(pool[i].taskFd);
+            close(pool[i].resultFd);
+        }
+        close(toWorker[1]);
+        close(toParent[0]);
+        ensembleWorker(base, toWorker[0], toParent[1]);
+    }
+    close(toWorker[0]);
+    close(toParent[1]);
+    worker->taskFd   = toWorker[1];
+    worker->resultFd = toParent[0];
+    worker->member   = -1;
+}
+
+static void stopEnsembleWorker(EnsembleWorkerProcess *worker)
+{
+    int quit = -1;
+    (void) writeFully(worker->taskFd, &quit, sizeof(int));
+    close(worker->taskFd);
+    close(worker->resultFd);
+    waitpid(worker->pid, NULL, 0);
+    worker->pid = 0;
+}
+
+static void batchEnsemble(char *inputFile, char *ensembleFile, char *outputFile)
+{
+    EnsembleWorkerProcess *pool;
+    struct pollfd *fds;
+    SilminState *base;
+    FILE *output;
+    double **values = NULL;                    /* [step][member*ensembleNValues] */
+    int **reported = NULL, nSteps = 0, nextStep = 0;   /* [step][member]         */
+    int *lastStep, next = 0, nDone = 0, nFailed = 0, i, m;
+
+    printf("---> Initializing data structures using selected calculation mode...\n");
+    SelectComputeDataStruct();
+    InitComputeDataStruct();
+    if (silminState == NULL) silminState = allocSilminStatePointer();
+    if (!batchInputDataFromFile(inputFile)) {
+        printf("Error(s) detected on reading input file %s. Exiting.\n", inputFile);
+        exit(0);
+    }
+    if (!readEnsembleFile(ensembleFile)) {
+        printf("Error(s) detected on reading ensemble file %s. Exiting.\n", ensembleFile);
+        exit(0);
+    }
+    if ((output = fopen(outputFile, "w")) == NULL) {
+        printf("Cannot open output file %s.  Exiting ...\n", outputFile);
+        exit(0);
+    }
+    base = silminState;
+
+    for (i=0, ensembleNPhases=1; i<npc; i++) if (solids[i].type == PHASE) ensembleNPhases++;
+    ensemblePhase = (int *) malloc((size_t) ensembleNPhases*sizeof(int));
+    for (i=0, ensembleNPhases=1; i<npc; i++) if (solids[i].type == PHASE) ensemblePhase[ensembleNPhases++] = i;
+    ensembleNValues = 2 + ensembleNPhases + nc;
+    ensembleValues  = (double *) malloc((size_t) ensembleNValues*sizeof(double));
+    lastStep = (int *) calloc((size_t) ensembleMembers, sizeof(int));
+
+    printf("Running %d ensemble members on %d workers.\n", ensembleMembers, MIN(ensembleWorkers, ensembleMembers));
+    fprintf(output, "step,T (C),P (bars),quantity,n,mean,sd,q05,q25,q50,q75,q95\n");
+
+    pool = (EnsembleWorkerProcess *) calloc((size_t) ensembleWorkers, sizeof(EnsembleWorkerProcess));
+    fds  = (struct pollfd *) calloc((size_t) ensembleWorkers, sizeof(struct pollfd));
+    (void) signal(SIGPIPE, SIG_IGN);
+    for (i=0; (i<ensembleWorkers) && (next<ensembleMembers); i++) {
+        startEnsembleWorker(base, &pool[i], pool);
+        pool[i].member = next;
+        (void) writeFully(pool[i].taskFd, &next, sizeof(int));
+        next++;
+    }
+
+    while (nDone < ensembleMembers) {
+        for (i=0; i<ensembleWorkers; i++) {
+            fds[i].fd     = (pool[i].pid > 0) ? pool[i].resultFd : -1;
+            fds[i].events = POLLIN;
+        }
+        if (poll(fds, (nfds_t) ensembleWorkers, -1) < 0) continue;
+
+        for (i=0; i<ensembleWorkers; i++) if ((pool[i].pid > 0) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+            EnsembleRecord record;
+            int finished = FALSE;
+
+            if (!readFully(pool[i].resultFd, &record, sizeof(EnsembleRecord))) {
+                /* worker died on the member it was running */
+                close(pool[i].taskFd);
+                close(pool[i].resultFd);
+                waitpid(pool[i].pid, NULL, 0);
+                pool[i].pid = 0;
+                lastStep[pool[i].member] = -1;
+                nFailed++;
+                finished = TRUE;
+                if (next < ensembleMembers) startEnsembleWorker(base, &pool[i], pool);
+            } else if (record.step < 0) {
+                lastStep[record.member] = -1;
+                if (record.status != SILMIN_SUCCESS) nFailed++;
+                finished = TRUE;
+            } else {
+                if (record.step >= nSteps) {
+                    values   = (double **) REALLOC(values,   (size_t) (record.step+1)*sizeof(double *));
+                    reported = (int **)    REALLOC(reported, (size_t) (record.step+1)*sizeof(int *));
+                    for (; nSteps<=record.step; nSteps++) {
+                        values[nSteps]   = (double *) malloc((size_t) ensembleMembers*ensembleNValues*sizeof(double));
+                        reported[nSteps] = (int *)    calloc((size_t) ensembleMembers, sizeof(int));
+                    }
+                }
+                if (!readFully(pool[i].resultFd, &values[record.step][record.member*ensembleNValues], (size_t) ensembleNValues*sizeof(double))) continue;
+                reported[record.step][record.member] = TRUE;
+                lastStep[record.member] = record.step + 1;
+            }
+
+            if (finished) {
+                nDone++;
+                if (pool[i].pid > 0) {
+                    if (next < ensembleMembers) {
+                        pool[i].member = next;
+                        (void) writeFully(pool[i].taskFd, &next, sizeof(int));
+                        next++;
+                    } else stopEnsembleWorker(&pool[i]);
+                }
+            }
+
+            /* a step is complete once every member has passed it or finished */
+            while (nextStep < nSteps) {
+                for (m=0; m<ensembleMembers; m++) if ((lastStep[m] >= 0) && (lastStep[m] <= nextStep)) break;
+                if (m < ensembleMembers) break;
+                putEnsembleStep(output, nextStep, values[nextStep], reported[nextStep]);
+                free(values[nextStep]);   values[nextStep]   = NULL;
+                free(reported[nextStep]); reported[nextStep] = NULL;
+                nextStep++;
+            }
+        }
+    }
+
+    for (i=0; i<ensembleWorkers; i++) if (pool[i].pid > 0) stopEnsembleWorker(&pool[i]);
+    printf("Completed %d ensemble member(s), %d of which failed, in %d step(s).\n", ensembleMembers, nFailed, nSteps);
+    fclose(output);
+    free(fds);
+    free(pool);
+    free(lastStep);
+}
+
+/* Pseudosection mode.  Maps the stable assemblage of one .melts input over
+   a temperature-pressure rectangle.  The corners of a coarse grid are
+   equilibrated first; a cell whose corners differ in assemblage is split
+   into four, and so on for a given number of levels, so that the finest
+   spacing is only used near field boundaries.  A point added by a split
+   starts from the converged state of the nearest corner of its cell (a warm
+   start), and is run again from the input state if that fails.  The points
+   of a level are equilibrated by forked worker processes, as in ensemble
+   mode.  A field smaller than a coarse cell may be missed.
+
+   Writes prefix-points.csv, with the phase proportions at every point, and
+   prefix-fields.csv, with the boundary of each assemblage field as closed
+   rings of (T, P) vertices, traced along the finest grid; outer rings run
+   counterclockwise and holes clockwise with T on the horizontal axis.  The
+   cells of the finest grid with mixed corners go to the majority assemblage.
+
+   The grid file holds records in the style of a .melts file:
+     Temperature: 900 1300 9             (C; first, last, number of points)
+     Pressure: 500 10000 6               (bars; first, last, number of points)
+     Refinement: 3                       (levels of splitting, default 3)
+     Workers: 8                          (default: number of processors)   */
+
+typedef struct _pseudosectionPoint {
+    int level;           /* refinement level at which the point was added    */
+    int seedFrom;        /* grid point whose state starts this one, or -1    */
+    int status;          /* meltsStatus.status, or -1 until equilibrated     */
+    int warm;            /* TRUE if the result came from a warm start        */
+    int *key;            /* coexisting liquids then solids; key[0] -1 if failed */
+    double *values;      /* wt % of the system in each phase, liquid first   */
+    CompactState *seed;  /* converged state, NULL if failed                  */
+} PseudosectionPoint;
+
+typedef struct _pseudosectionTask {
+    int point;           /* -1 to stop the worker                            */
+    double t, p;         /* K, bars                                          */
+    size_t seedSize;     /* bytes of the starting state that follow, if any  */
+} PseudosectionTask;
+
+typedef struct _pseudosectionResult {
+    int point;
+    int status;
+    int warm;
+    size_t seedSize;     /* bytes of the converged state after the values    */
+} PseudosectionResult;
+
+typedef struct _pseudosectionWorkerProcess {
+    pid_t pid;
+    int   taskFd;
+    int   resultFd;
+    int   point;         /* point in progress, -1 if idle                    */
+} PseudosectionWorkerProcess;
+
+static int psCoarseT = 0, psCoarseP = 0, psLevels = 3, psWorkers = 0;
+static double psTmin, psTmax, psPmin, psPmax;
+static int psNT, psNP;   /* points on each axis of the finest grid         */
+static int psNPhases, *psPhase;
+static PseudosectionPoint **psPoint;   /* [j*psNT+i], NULL if not evaluated */
+
+#define PS_T(i) (psTmin + (psTmax - psTmin)*((double) (i))/((double) (psNT-1)))
+#define PS_P(j) (psPmin + (psPmax - psPmin)*((double) (j))/((double) (psNP-1)))
+
+static int readPseudosectionFile(char *fileName)
+{
+    FILE *input;
+    char line[REC];
+    size_t len;
+    int i;
+    float temporary1, temporary2;
+
+    if ((input = fopen(fileName, "r")) == NULL) {
+        printf("Error in pseudosection input procedure. Cannot open file: %s\n", fileName);
+        return FALSE;
+    }
+    psWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    while (fgets(line, REC, input) != NULL) {
+        len = strlen(line); for (i=0; i<(int) len; i++) line[i] = tolower(line[i]);
+        if (strspn(line, " \t\r\n") == len) continue;
+
+        if        (!strncmp(line, "temperature: ", 13)) {
+            if (sscanf(&line[13], "%f %f %d", &temporary1, &temporary2, &psCoarseT) != 3) { fclose(input); return FALSE; }
+            psTmin = (double) temporary1; psTmax = (double) temporary2;
+        } else if (!strncmp(line, "pressure: ",     10)) {
+            if (sscanf(&line[10], "%f %f %d", &temporary1, &temporary2, &psCoarseP) != 3) { fclose(input); return FALSE; }
+            psPmin = (double) temporary1; psPmax = (double) temporary2;
+        } else if (!strncmp(line, "refinement: ",   12)) {
+            if (sscanf(&line[12], "%d", &psLevels) != 1)  { fclose(input); return FALSE; }
+        } else if (!strncmp(line, "workers: ",       9)) {
+            if (sscanf(&line[9],  "%d", &psWorkers) != 1) { fclose(input); return FALSE; }
+        } else {
+            fclose(input);
+            return FALSE;
+        }
+    }
+    fclose(input);
+
+    if ((psCoarseT < 2) || (psCoarseP < 2) || (psTmax <= psTmin) || (psPmax <= psPmin) || (psPmin < 1.0)) return FALSE;
+    if ((psLevels < 0) || (psLevels > 12)) return FALSE;
+    psNT = (psCoarseT-1)*(1 << psLevels) + 1;
+    psNP = (psCoarseP-1)*(1 << psLevels) + 1;
+    if ((double) psNT*(double) psNP > 1.0e7) return FALSE;
+    if (psWorkers < 1) psWorkers = 1;
+    return TRUE;
+}
+
+/* Stands in for the output files of each converged step */
+static void pseudosectionStepOutput(void)
+{
+}
+
+/* Assemblage and phase proportions (wt % of the system) of silminState */
+static void pseudosectionAssemblage(int *key, double *values)
+{
+    double total = silminState->liquidMass;
+    int i, j, k, ns;
+
+    for (k=0; k<psNPhases; k++) values[k] = 0.0;
+    key[0] = (silminState->liquidMass > 0.0) ? MAX(1, silminState->nLiquidCoexist) : 0;
+    values[0] = silminState->liquidMass;
+
+    for (k=1; k<psNPhases; k++) {
+        i = psPhase[k];
+        key[k] = (silminState->nSolidCoexist)[i];
+        for (ns=0; ns<key[k]; ns++) {
+            if (solids[i].na == 1) {
+                for (j=0; j<nc; j++) values[k] += (silminState->solidComp)[i][ns]*(solids[i].solToOx)[j]*bulkSystem[j].mw;
+            } else {
+                int a;
+                for (a=0; a<solids[i].na; a++) for (j=0; j<nc; j++)
+                    values[k] += (silminState->solidComp)[i+1+a][ns]*(solids[i+1+a].solToOx)[j]*bulkSystem[j].mw;
+            }
+        }
+        total += values[k];
+    }
+    if (total > 0.0) for (k=0; k<psNPhases; k++) values[k] *= 100.0/total;
+}
+
+/* Single equilibration at t and p; fractionation, constrained paths and
+   adaptive steps are switched off in the base state                       */
+static void setPseudosectionPoint(double t, double p)
+{
+    silminState->T         = t;
+    silminState->dspTstart = t;
+    silminState->dspTstop  = t;
+    silminState->dspTinc   = 0.0;
+    silminState->P         = p;
+    silminState->dspPstart = p;
+    silminState->dspPstop  = p;
+    silminState->dspPinc   = 0.0;
+}
+
+static void destroyPseudosectionState(void)
+{
+    free(silminState->ySol);
+    free(silminState->yLiq);
+    silminState->ySol = NULL;
+    silminState->yLiq = NULL;
+    destroySilminStateStructure(silminState);
+    silminState = NULL;
+}
+
+static void pseudosectionWorker(SilminState *base, int taskFd, int resultFd)
+{
+    PseudosectionTask task;
+    PseudosectionResult result;
+    CompactState *seed, *state;
+    int *key = (int *) malloc((size_t) psNPhases*sizeof(int)), attempt;
+    double *values = (double *) malloc((size_t) psNPhases*sizeof(double));
+
+    (void) freopen("/dev/null", "w", stdout);
+    (void) freopen("/dev/null", "w", stderr);
+    meltsStepOutput = pseudosectionStepOutput;
+
+    while (readFully(taskFd, &task, sizeof(PseudosectionTask)) && (task.point >= 0)) {
+        seed = NULL;
+        if (task.seedSize > 0) {
+            seed = (CompactState *) malloc(task.seedSize);
+            if (!readFully(taskFd, seed, task.seedSize)) break;
+        }
+
+        /* a warm start that fails is run again from the input state */
+        for (attempt=((seed != NULL) ? 0 : 1); attempt<2; attempt++) {
+            silminState = (attempt == 0) ? unpackSilminState(seed) : copySilminStateStructure(base, NULL);
+            setPseudosectionPoint(task.t, task.p);
+            meltsWarmStart = (attempt == 0);
+            meltsStatus.status = GENERIC_INTERNAL_ERROR;
+            while(!silmin());
+            if ((meltsStatus.status == SILMIN_SUCCESS) || (attempt == 1)) break;
+            destroyPseudosectionState();
+        }
+        meltsWarmStart = FALSE;
+        free(seed);
+
+        state = NULL;
+        if (meltsStatus.status == SILMIN_SUCCESS) {
+            pseudosectionAssemblage(key, values);
+            state = packSilminState(silminState);
+        } else {
+            int k;
+            for (k=0; k<psNPhases; k++) { key[k] = -1; values[k] = 0.0; }
+        }
+        result.point    = task.point;
+        result.status   = meltsStatus.status;
+        result.warm     = (attempt == 0);
+        result.seedSize = (state != NULL) ? state->size : 0;
+        if (!writeFully(resultFd, &result, sizeof(PseudosectionResult))
+            || !writeFully(resultFd, key, (size_t) psNPhases*sizeof(int))
+            || !writeFully(resultFd, values, (size_t) psNPhases*sizeof(double))
+            || ((state != NULL) && !writeFully(resultFd, state, state->size))) break;
+        free(state);
+        destroyPseudosectionState();
+    }
+    _exit(0);
+}
+
+static void startPseudosectionWorker(SilminState *base, PseudosectionWorkerProcess *worker, PseudosectionWorkerProcess *pool)
+{
+    int toWorker[2], toParent[2], i;
+
+    if ((pipe(toWorker) != 0) || (pipe(toParent) != 0)) { printf("Cannot create pipes for pseudosection workers.  Exiting ...\n"); exit(0); }
+    (void) fflush(stdout);
+    if ((worker->pid = fork()) < 0) { printf("Cannot fork pseudosection workers.  Exiting ...\n"); exit(0); }
+    if (worker->pid == 0) {
+        for (i=0; i<psWorkers; i++) if ((pool+i != worker) && (pool[i].pid > 0)) {
+            close(pool[i].taskFd);
+            close(pool[i].resultFd);
+        }
+        close(toWorker[1]);
+        close(toParent[0]);
+        pseudosectionWorker(base, toWorker[0], toParent[1]);
+    }
+    close(toWorker[0]);
+    close(toParent[1]);
+    worker->taskFd   = toWorker[1];
+    worker->resultFd = toParent[0];
+    worker->point    = -1;
+}
+
+static void stopPseudosectionWorker(PseudosectionWorkerProcess *worker)
+{
+    PseudosectionTask quit;
+    memset(&quit, 0, sizeof(PseudosectionTask));
+    quit.point = -1;
+    (void) writeFully(worker->taskFd, &quit, sizeof(PseudosectionTask));
+    close(worker->taskFd);
+    close(worker->resultFd);
+    waitpid(worker->pid, NULL, 0);
+    worker->pid = 0;
+}
+
+static void sendPseudosectionTask(PseudosectionWorkerProcess *worker, int point)
+{
+    PseudosectionTask task;
+    CompactState *seed = (psPoint[point]->seedFrom >= 0) ? psPoint[psPoint[point]->seedFrom]->seed : NULL;
+
+    memset(&task, 0, sizeof(PseudosectionTask));
+    task.point    = point;
+    task.t        = PS_T(point % psNT) + 273.15;
+    task.p        = PS_P(point / psNT);
+    task.seedSize = (seed != NULL) ? seed->size : 0;
+    worker->point = point;
+    if (!writeFully(worker->taskFd, &task, sizeof(PseudosectionTask))) return;
+    if (seed != NULL) (void) writeFully(worker->taskFd, seed, seed->size);
+}
+
+static void failPseudosectionPoint(PseudosectionPoint *point)
+{
+    int k;
+    point->status = GENERIC_INTERNAL_ERROR;
+    point->warm   = FALSE;
+    for (k=0; k<psNPhases; k++) { (point->key)[k] = -1; (point->values)[k] = 0.0; }
+}
+
+/* Equilibrates the n points of batch[] on the worker pool */
+static void evaluatePseudosectionPoints(SilminState *base, PseudosectionWorkerProcess *pool, struct pollfd *fds, int *batch, int n)
+{
+    int next = 0, nDone = 0, i;
+
+    for (i=0; (i<psWorkers) && (next<n); i++) {
+        if (pool[i].pid == 0) startPseudosectionWorker(base, &pool[i], pool);
+        sendPseudosectionTask(&pool[i], batch[next++]);
+    }
+
+    while (nDone < n) {
+        for (i=0; i<psWorkers; i++) {
+            fds[i].fd     = ((pool[i].pid > 0) && (pool[i].point >= 0)) ? pool[i].resultFd : -1;
+            fds[i].events = POLLIN;
+        }
+        if (poll(fds, (nfds_t) psWorkers, -1) < 0) continue;
+
+        for (i=0; i<psWorkers; i++) if ((fds[i].fd >= 0) && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+            PseudosectionResult result;
+            PseudosectionPoint *point = psPoint[pool[i].point];
+            int received = readFully(pool[i].resultFd, &result, sizeof(PseudosectionResult))
+                && readFully(pool[i].resultFd, point->key, (size_t) psNPhases*sizeof(int))
+                && readFully(pool[i].resultFd, point->values, (size_t) psNPhases*sizeof(double));
+
+            if (received && (result.seedSize > 0)) {
+                point->seed = (CompactState *) malloc(result.seedSize);
+                received = readFully(pool[i].resultFd, point->seed, result.seedSize);
+            }
+            if (!received) {
+                /* worker died on the point it was running */
+                free(point->seed);
+                point->seed = NULL;
+                failPseudosectionPoint(point);
+                close(pool[i].taskFd);
+                close(pool[i].resultFd);
+                waitpid(pool[i].pid, NULL, 0);
+                pool[i].pid = 0;
+                if (next < n) startPseudosectionWorker(base, &pool[i], pool);
+            } else {
+                point->status = result.status;
+                point->warm   = result.warm;
+            }
+            pool[i].point = -1;
+            nDone++;
+            if ((pool[i].pid > 0) && (next < n)) sendPseudosectionTask(&pool[i], batch[next++]);
+        }
+    }
+}
+
+/* Registers grid point (i, j) for the next batch, started from the nearest
+   successful corner of the cell with lower left corner (ci, cj) and side s */
+static void addPseudosectionPoint(int i, int j, int ci, int cj, int s, int level, int *batch, int *n)
+{
+    static const int cornerI[4] = {0, 1, 0, 1}, cornerJ[4] = {0, 0, 1, 1};
+    PseudosectionPoint *point;
+    int index = j*psNT + i, c, best = -1, bestDistance = 0;
+
+    if (psPoint[index] != NULL) return;
+    if (s > 0) for (c=0; c<4; c++) {
+        int corner = (cj + cornerJ[c]*s)*psNT + ci + cornerI[c]*s;
+        int distance = abs(ci + cornerI[c]*s - i) + abs(cj + cornerJ[c]*s - j);
+        if ((psPoint[corner]->seed != NULL) && ((best < 0) || (distance < bestDistance))) { best = corner; bestDistance = distance; }
+    }
+    point = (PseudosectionPoint *) calloc((size_t) 1, sizeof(PseudosectionPoint));
+    point->level    = level;
+    point->seedFrom = best;
+    point->status   = -1;
+    point->key      = (int *)    calloc((size_t) psNPhases, sizeof(int));
+    point->values   = (double *) calloc((size_t) psNPhases, sizeof(double));
+    psPoint[index]  = point;
+    batch[(*n)++]   = index;
+}
+
+/* Index of the field with the assemblage key, added if new */
+static int pseudosectionField(int *key, int ***fieldKey, int *nFields)
+{
+    int f;
+    for (f=0; f<*nFields; f++) if (!memcmp((*fieldKey)[f], key, (size_t) psNPhases*sizeof(int))) return f;
+    *fieldKey = (int **) REALLOC(*fieldKey, (size_t) (*nFields+1)*sizeof(int *));
+    (*fieldKey)[*nFields] = key;
+    return (*nFields)++;
+}
+
+static void putPseudosectionAssemblage(FILE *output, int *key)
+{
+    int k, first = TRUE;
+
+    if (key[0] < 0) { fprintf(output, "failed"); return; }
+    for (k=0; k<psNPhases; k++) if (key[k] > 0) {
+        fprintf(output, "%s%s", first ? "" : "+", (k == 0) ? "liquid" : solids[psPhase[k]].label);
+        if (key[k] > 1) fprintf(output, "(%d)", key[k]);
+        first = FALSE;
+    }
+    if (first) fprintf(output, "none");
+}
+
+/* Traces the boundary of each field of the finest cells as closed rings,
+   keeping the field on the left; only the corners of a ring are written  */
+static void putPseudosectionFields(FILE *output, int *cellField, int **fieldKey, int nFields)
+{
+    static const int di[4] = {1, 0, -1, 0}, dj[4] = {0, 1, 0, -1};
+    int nx = psNT-1, ny = psNP-1, nVertices = psNT*psNP;
+    unsigned char *edge = (unsigned char *) calloc((size_t) nVertices, sizeof(unsigned char));
+    int *ringVertex = NULL, *ringDirection = NULL, ringSize = 0;
+    int f, i, j, k, v, u, d, e, n, ring;
+
+    fprintf(output, "field,assemblage,ring,T (C),P (bars)\n");
+    for (f=0; f<nFields; f++) {
+        /* bit d of edge[v] marks a boundary edge leaving vertex v in direction d */
+        for (j=0; j<ny; j++) for (i=0; i<nx; i++) if (cellField[j*nx+i] == f) {
+            if ((j == 0)    || (cellField[(j-1)*nx+i] != f)) edge[j*psNT+i]         |= 1;
+            if ((i == nx-1) || (cellField[j*nx+i+1]   != f)) edge[j*psNT+i+1]       |= 2;
+            if ((j == ny-1) || (cellField[(j+1)*nx+i] != f)) edge[(j+1)*psNT+i+1]   |= 4;
+            if ((i == 0)    || (cellField[j*nx+i-1]   != f)) edge[(j+1)*psNT+i]     |= 8;
+        }
+
+        for (v=0, ring=0; v<nVertices; v++) while (edge[v]) {
+            for (d=0; !(edge[v] & (1 << d)); d++);
+            for (u=v, n=0; ; n++) {
+                if (n >= ringSize) {
+                    ringSize = MAX(2*ringSize, 64);
+                    ringVertex    = (int *) REALLOC(ringVertex,    (size_t) ringSize*sizeof(int));
+                    ringDirection = (int *) REALLOC(ringDirection, (size_t) ringSize*sizeof(int));
+                }
+                ringVertex[n] = u; ringDirection[n] = d;
+                edge[u] &= ~(1 << d);
+                u += dj[d]*psNT + di[d];
+                /* turn left if possible, else go straight, else turn right */
+                for (k=1; k>=-1; k--) if (edge[u] & (1 << (e = (d+k+4) % 4))) break;
+                if (k < -1) break;
+                d = e;
+            }
+            n++;
+            for (k=0; k<n; k++) if (ringDirection[k] != ringDirection[(k+n-1) % n]) {
+                fprintf(output, "%d,", f+1);
+                putPseudosectionAssemblage(output, fieldKey[f]);
+                fprintf(output, ",%d,%.4f,%.4f\n", ring+1, PS_T(ringVertex[k] % psNT), PS_P(ringVertex[k] / psNT));
+            }
+            ring++;
+        }
+    }
+    free(ringVertex);
+    free(ringDirection);
+    free(edge);
+}
+
+static void batchPseudosection(char *inputFile, char *gridFile, char *outputPrefix)
+{
+    static const int cornerI[4] = {0, 1, 0, 1}, cornerJ[4] = {0, 0, 1, 1};
+    PseudosectionWorkerProcess *pool;
+    struct pollfd *fds;
+    SilminState *base;
+    FILE *points, *fields;
+    char *fileName;
+    int *cells, *newCells, nCells = 0, nNewCells, *batch, nBatch = 0, *cellField, **fieldKey = NULL, nFields = 0;
+    int *present, nPoints = 0, nWarm = 0, nFailed = 0, level, s, c, i, j, k, m;
+
+    printf("---> Initializing data structures using selected calculation mode...\n");
+    SelectComputeDataStruct();
+    InitComputeDataStruct();
+    if (silminState == NULL) silminState = allocSilminStatePointer();
+    if (!batchInputDataFromFile(inputFile)) {
+        printf("Error(s) detected on reading input file %s. Exiting.\n", inputFile);
+        exit(0);
+    }
+    if (!readPseudosectionFile(gridFile)) {
+        printf("Error(s) detected on reading grid file %s. Exiting.\n", gridFile);
+        exit(0);
+    }
+    fileName = (char *) malloc(strlen(outputPrefix) + 12);
+    (void) strcpy(fileName, outputPrefix); (void) strcat(fileName, "-points.csv");
+    if ((points = fopen(fileName, "w")) == NULL) { printf("Cannot open output file %s.  Exiting ...\n", fileName); exit(0); }
+    (void) strcpy(fileName, outputPrefix); (void) strcat(fileName, "-fields.csv");
+    if ((fields = fopen(fileName, "w")) == NULL) { printf("Cannot open output file %s.  Exiting ...\n", fileName); exit(0); }
+    free(fileName);
+
+    base = silminState;
+    base->fractionateSol = FALSE;
+    base->fractionateFlu = FALSE;
+    base->fractionateLiq = FALSE;
+    base->isenthalpic    = FALSE;
+    base->isentropic     = FALSE;
+    base->isochoric      = FALSE;
+    base->refEnthalpy    = 0.0;
+    base->refEntropy     = 0.0;
+    base->refVolume      = 0.0;
+    meltsStepControl.adaptive = FALSE;
+
+    for (i=0, psNPhases=1; i<npc; i++) if (solids[i].type == PHASE) psNPhases++;
+    psPhase = (int *) malloc((size_t) psNPhases*sizeof(int));
+    for (i=0, psNPhases=1; i<npc; i++) if (solids[i].type == PHASE) psPhase[psNPhases++] = i;
+
+    psPoint   = (PseudosectionPoint **) calloc((size_t) psNT*psNP, sizeof(PseudosectionPoint *));
+    cellField = (int *) malloc((size_t) (psNT-1)*(psNP-1)*sizeof(int));
+    cells     = (int *) malloc((size_t) 2*(psCoarseT-1)*(psCoarseP-1)*sizeof(int));
+    batch     = (int *) malloc((size_t) psCoarseT*psCoarseP*sizeof(int));
+    pool = (PseudosectionWorkerProcess *) calloc((size_t) psWorkers, sizeof(PseudosectionWorkerProcess));
+    fds  = (struct pollfd *) calloc((size_t) psWorkers, sizeof(struct pollfd));
+    (void) signal(SIGPIPE, SIG_IGN);
+
+    printf("Mapping a %d x %d grid with %d level(s) of refinement on %d workers.\n", psCoarseT, psCoarseP, psLevels, psWorkers);
+    s = 1 << psLevels;
+    for (j=0; j<psCoarseP; j++) for (i=0; i<psCoarseT; i++) {
+        if ((i < psCoarseT-1) && (j < psCoarseP-1)) { cells[2*nCells] = i*s; cells[2*nCells+1] = j*s; nCells++; }
+        addPseudosectionPoint(i*s, j*s, 0, 0, 0, 0, batch, &nBatch);
+    }
+
+    for (level=0; nBatch>0; level++) {
+        printf("Level %d: equilibrating %d point(s).\n", level, nBatch);
+        (void) fflush(stdout);
+        evaluatePseudosectionPoints(base, pool, fds, batch, nBatch);
+        nPoints += nBatch;
+        free(batch);
+
+        /* cells with differing corners are split, the others are final */
+        newCells = (int *) malloc((size_t) 8*nCells*sizeof(int));
+        batch    = (int *) malloc((size_t) 5*nCells*sizeof(int));
+        for (c=0, nNewCells=0, nBatch=0; c<nCells; c++) {
+            int ci = cells[2*c], cj = cells[2*c+1], corner[4], field[4], count[4], uniform = TRUE;
+
+            for (k=0; k<4; k++) {
+                corner[k] = (cj + cornerJ[k]*s)*psNT + ci + cornerI[k]*s;
+                field[k]  = pseudosectionField(psPoint[corner[k]]->key, &fieldKey, &nFields);
+                if (field[k] != field[0]) uniform = FALSE;
+            }
+            if (!uniform && (s > 1)) {
+                int h = s/2;
+                for (k=0; k<4; k++) {
+                    newCells[2*nNewCells]   = ci + cornerI[k]*h;
+                    newCells[2*nNewCells+1] = cj + cornerJ[k]*h;
+                    nNewCells++;
+                }
+                addPseudosectionPoint(ci+h, cj,   ci, cj, s, level+1, batch, &nBatch);
+                addPseudosectionPoint(ci,   cj+h, ci, cj, s, level+1, batch, &nBatch);
+                addPseudosectionPoint(ci+h, cj+h, ci, cj, s, level+1, batch, &nBatch);
+                addPseudosectionPoint(ci+s, cj+h, ci, cj, s, level+1, batch, &nBatch);
+                addPseudosectionPoint(ci+h, cj+s, ci, cj, s, level+1, batch, &nBatch);
+            } else {
+                for (k=0; k<4; k++) for (m=0, count[k]=0; m<4; m++) if (field[m] == field[k]) count[k]++;
+                for (k=1, m=0; k<4; k++) if (count[k] > count[m]) m = k;
+                for (j=cj; j<cj+s; j++) for (i=ci; i<ci+s; i++) cellField[j*(psNT-1)+i] = field[m];
+            }
+        }
+        free(cells);
+        cells  = newCells;
+        nCells = nNewCells;
+        s /= 2;
+    }
+    for (i=0; i<psWorkers; i++) if (pool[i].pid > 0) stopPseudosectionWorker(&pool[i]);
+
+    present = (int *) calloc((size_t) psNPhases, sizeof(int));
+    for (m=0; m<psNT*psNP; m++) if (psPoint[m] != NULL) {
+        for (k=0; k<psNPhases; k++) if ((psPoint[m]->key)[k] > 0) present[k] = TRUE;
+        if (psPoint[m]->warm) nWarm++;
+        if (psPoint[m]->status != SILMIN_SUCCESS) nFailed++;
+    }
+    fprintf(points, "T (C),P (bars),level,warm start,assemblage");
+    for (k=0; k<psNPhases; k++) if (present[k]) fprintf(points, ",%s (wt %%)", (k == 0) ? "liquid" : solids[psPhase[k]].label);
+    fprintf(points, "\n");
+    for (m=0; m<psNT*psNP; m++) if (psPoint[m] != NULL) {
+        fprintf(points, "%.4f,%.4f,%d,%d,", PS_T(m % psNT), PS_P(m / psNT), psPoint[m]->level, psPoint[m]->warm);
+        putPseudosectionAssemblage(points, psPoint[m]->key);
+        for (k=0; k<psNPhases; k++) if (present[k]) fprintf(points, ",%.6f", (psPoint[m]->values)[k]);
+        fprintf(points, "\n");
+    }
+    putPseudosectionFields(fields, cellField, fieldKey, nFields);
+    printf("Equilibrated %d point(s), %d from a warm start and %d failed, in %d field(s).\n", nPoints, nWarm, nFailed, nFields);
+
+    fclose(points);
+    fclose(fields);
+    for (m=0; m<psNT*psNP; m++) if (psPoint[m] != NULL) {
+        free(psPoint[m]->key);
+        free(psPoint[m]->values);
+        free(psPoint[m]->seed);
+        free(psPoint[m]);
+    }
+    free(psPoint);
+    free(present);
+    free(fieldKey);
+    free(cellField);
+    free(cells);
+    free(batch);
+    free(fds);
+    free(pool);
+    free(psPhase);
+}
+
+#endif /* MINGW */
+
 #endif /* BATCH_VERSION */
 
 /*****************/
@@ -2624,8 +3940,56 @@ int main (int argc, char *argv[])
             printf("  Melts-batch inputDir outputDir [inputProcessedDir]\n");
             printf("              Directories are stipulated relative to current directory\n");
             printf("              with no trailing delimiter.\n");
+            printf("  Melts-batch -stream input.xml|- output.xml\n");
+            printf("              Processes a file or pipe of concatenated MELTSinput documents.\n");
+#ifndef MINGW
+            printf("  Melts-batch -socket path\n");
+            printf("  Melts-batch -port number\n");
+            printf("              Server mode on a Unix domain socket or a loopback TCP port.\n");
+            printf("  Melts-batch -ensemble input.melts perturbations.txt output.csv\n");
+            printf("              Runs perturbed copies of input.melts and writes statistics per step.\n");
+            printf("  Melts-batch -pseudosection input.melts grid.txt output-prefix\n");
+            printf("              Maps assemblage fields over a T-P grid refined at their boundaries.\n");
+#endif
             exit(0);
 
+        } else if (!strcmp(argv[1], "-stream")) {
+            if (argc < 4) {
+                printf("Usage:\n");
+                printf("  Melts-batch -stream input.xml|- output.xml\n");
+                exit(0);
+            }
+            batchStream(argv[2], argv[3]);
+
+#ifndef MINGW
+        } else if (!strcmp(argv[1], "-ensemble")) {
+            if (argc < 5) {
+                printf("Usage:\n");
+                printf("  Melts-batch -ensemble input.melts perturbations.txt output.csv\n");
+                exit(0);
+            }
+            batchEnsemble(argv[2], argv[3], argv[4]);
+
+        } else if (!strcmp(argv[1], "-pseudosection")) {
+            if (argc < 5) {
+                printf("Usage:\n");
+                printf("  Melts-batch -pseudosection input.melts grid.txt output-prefix\n");
+                exit(0);
+            }
+            batchPseudosection(argv[2], argv[3], argv[4]);
+
+        } else if (!strcmp(argv[1], "-socket") || !strcmp(argv[1], "-port")) {
+            if (argc < 3) {
+                printf("Usage:\n");
+                printf("  Melts-batch -socket path\n");
+                printf("  Melts-batch -port number\n");
+                exit(0);
+            }
+            if      (!strcmp(argv[1], "-socket")) batchServer(argv[2], 0);
+            else if (atoi(argv[2]) > 0)           batchServer(NULL, atoi(argv[2]));
+            else { printf("Invalid port number %s.  Exiting ...\n", argv[2]); exit(0); }
+
+#endif
         } else if (strstr(argv[1], ".melts") != NULL) {
             int i, j, k, l;
 
@@ -38,6 +38,9 @@ void raise_sigabrt(DWORD dwType);
 #endif
 
 static void doBatchFractionation(void);
+static SilminState *createSilminState(void);
+
+extern SilminState *bestState; /* silmin.c */
 
 int calculationMode = MODE__MELTS;
 int quad_tol_modifier = 1;
@@ -53,31 +56,130 @@ char *addOutputFileName = NULL;
 
 static int iAmInitialized = FALSE;
 
+/* One model instance per set of liquid and solid tables (MELTS, MELTS+fluid,
+   pMELTS).  InitComputeDataStruct() is run on each set when the library is
+   initialized; afterwards selecting a model only swaps the global tables, so
+   nodes calibrated with different modes can be run in the same process.
+   The liquid kernel (liquid_v34.c, liquid_CO2.c, liquid_CO2_H2O.c) follows
+   calculationMode, which is set along with the tables.                      */
+
+typedef struct _meltsModel {
+  int initialized;
+  Liquid *liquid;
+  Solids *solids;
+  int nlc, nls, npc, maxNa, maxNr;
+  Oxygen oxygen;
+  double **oxToLiq; /* bulkSystem[].oxToLiq, which depends on the liquid */
+  struct _phaseList *phaseList;
+  int np;
+} MeltsModel;
+static MeltsModel meltsModel[3];
+static MeltsModel *currentModel;
+
+static void saveModel(void);
+static void restoreModel(MeltsModel *model);
+
+static MeltsModel *modelForMode(int mode) {
+  MeltsModel *model = NULL;
+
+  if ((mode == MODE__MELTS) || (mode == MODE_xMELTS)) {
+    model = &meltsModel[0];
+    model->liquid = meltsLiquid;
+    model->solids = meltsSolids;
+    model->nlc    = meltsNlc;
+    model->nls    = meltsNls;
+    model->npc    = meltsNpc;
+  } else if ((mode == MODE__MELTSandCO2) || (mode == MODE__MELTSandCO2_H2O)) {
+    model = &meltsModel[1];
+    model->liquid = meltsFluidLiquid;
+    model->solids = meltsFluidSolids;
+    model->nlc    = meltsFluidNlc;
+    model->nls    = meltsFluidNls;
+    model->npc    = meltsFluidNpc;
+  } else if (mode == MODE_pMELTS) {
+    model = &meltsModel[2];
+    model->liquid = pMeltsLiquid;
+    model->solids = pMeltsSolids;
+    model->nlc    = pMeltsNlc;
+    model->nls    = pMeltsNls;
+    model->npc    = pMeltsNpc;
+  }
+  return model;
+}
+
+static void initializeModel(MeltsModel *model) {
+  int i;
+
+  liquid = model->liquid;
+  solids = model->solids;
+  nlc    = model->nlc;
+  nls    = model->nls;
+  npc    = model->npc;
+  InitComputeDataStruct();
+
+  for (i=0, model->maxNa=1, model->maxNr=0; i<npc; i++) if (solids[i].type == PHASE) {
+    model->maxNa = MAX(model->maxNa, solids[i].na);
+    model->maxNr = MAX(model->maxNr, solids[i].nr);
+  }
+  model->oxygen      = oxygen;
+  model->oxToLiq     = (double **) malloc((size_t) nc*sizeof(double *));
+  for (i=0; i<nc; i++) (model->oxToLiq)[i] = bulkSystem[i].oxToLiq;
+  model->phaseList   = NULL;
+  model->np          = 0;
+  model->initialized = TRUE;
+}
+
+/* Work space in silmin() and friends is allocated on first use, so it is
+   sized through workNpc, workNa and workNr for the largest of the models
+   before any of them is used.  xMELTS modifies the MELTS tables in place and
+   is not mixed with the other modes.                                        */
+
 static void initializeLibrary(void) {
+  int i, mode = calculationMode, modes[3] = { MODE__MELTS, MODE__MELTSandCO2, MODE_pMELTS };
 
-  if ((calculationMode == MODE__MELTS) || (calculationMode == MODE_xMELTS)) {
-    liquid = meltsLiquid;
-    solids = meltsSolids;
-    nlc    = meltsNlc;
-    nls    = meltsNls;
-    npc    = meltsNpc;
-  } else if ((calculationMode == MODE__MELTSandCO2) || (calculationMode == MODE__MELTSandCO2_H2O)) {
-    liquid = meltsFluidLiquid;
-    solids = meltsFluidSolids;
-    nlc = meltsFluidNlc;
-    nls = meltsFluidNls;
-    npc = meltsFluidNpc;
-  } else if (calculationMode == MODE_pMELTS) {
-    liquid = pMeltsLiquid;
-    solids = pMeltsSolids;
-    nlc    = pMeltsNlc;
-    nls    = pMeltsNls;
-    npc    = pMeltsNpc;
+  /* silmin() tests the input file name (for an .xml suffix) */
+  if (silminInputData.name == NULL) {
+    silminInputData.name = (char *) malloc((size_t) (REC+1)*sizeof(char));
+    (void) strcpy(silminInputData.name, "libMELTS");
+  }
+  if (mode != MODE_xMELTS) for (i=0; i<3; i++) {
+    calculationMode = modes[i];
+    initializeModel(modelForMode(modes[i]));
+  }
+  calculationMode = mode;
+  currentModel = modelForMode(calculationMode);
+  if (currentModel->initialized) restoreModel(currentModel);
+  else                           initializeModel(currentModel);
+
+  for (i=0; i<3; i++) if (meltsModel[i].initialized) {
+    workNpc = MAX(workNpc, meltsModel[i].npc);
+    workNa  = MAX(workNa,  meltsModel[i].maxNa);
+    workNr  = MAX(workNr,  meltsModel[i].maxNr);
   }
-  InitComputeDataStruct();
   iAmInitialized = TRUE;
 }
 
+/* Makes the model for mode current.  Returns FALSE if the model cannot be
+   selected.                                                                 */
+
+static int selectModel(int mode) {
+  MeltsModel *model = modelForMode(mode);
+
+  if (!iAmInitialized) initializeLibrary();
+  if (mode == calculationMode) return TRUE;
+  if ((model == NULL) || (mode == MODE_xMELTS) || (calculationMode == MODE_xMELTS)) return FALSE;
+
+  if (model != currentModel) {
+    /* silmin() reuses the arrays of its best iterate, laid out for the tables */
+    if (bestState != NULL) { destroySilminStateStructure(bestState); bestState = NULL; }
+    saveModel();
+    restoreModel(model);
+    currentModel = model;
+  }
+  calculationMode = mode;
+  return TRUE;
+}
+
 /* ================================================================================== */
 /* ================================================================================== */
 /* Public interface for libMelts                                                      */
@@ -135,6 +237,10 @@ int setCalculationMode(int mode) {
     calculationMode = mode;
     initializeLibrary();
     return TRUE;
+  } else if ((mode != calculationMode) && selectModel(mode)) {
+    /* Nodes created from here on use the new mode; existing nodes keep theirs */
+    silminState = NULL;
+    return TRUE;
   } else {
     if (silminState != NULL) {
       int i, np;
@@ -331,7 +437,7 @@ static int comparePhases(const void *aPt, const void *bPt) {
   return strcmp(a->name, b->name);
 }
 
-static int np;
+static int np, keyLength;
 static PhaseList key;
 
 static void initializePhaseList (void) {
@@ -353,7 +459,7 @@ static void initializePhaseList (void) {
     }
     
   qsort(phaseList, (size_t) np, sizeof(struct _phaseList), comparePhases);
-  key.name = (char *) malloc((size_t) maxLength);
+  if (maxLength > keyLength) key.name = (char *) realloc(key.name, (size_t) (keyLength = maxLength));
 }
 
 void meltsgetweightsandformulas_(char *phaseName, double *endMemberWeights, char endMemberNames[], int *nCharInName, int *numberEndMembers) {
@@ -436,17 +542,318 @@ void getMeltsWeightsAndFormulas(int *failure, char *phaseName, double *endMember
 #endif
 }
 
+/* Largest change in bulk mass, relative to the total, that re-equilibrates a
+   converged node from its current assemblage (see meltsWarmStart)           */
+#define WARM_START_MAX_CHANGE 1.0e-3
+
+/* Inputs and results of the last call to meltsprocess_() for a node, kept
+   when memoization is enabled (see meltssetmemoization_)                     */
+typedef struct _nodeMemo {
+  int    valid;
+  int    mode, output, fo2Path, nCh;
+  double pressure, temperature, enthalpy, fo2Delta;
+  double *bulkIn;          /* [nc] grams                                     */
+  int    status, numberPhases;
+  double pressureOut, temperatureOut, enthalpyOut;
+  double *bulkOut;         /* [nc] grams                                     */
+  char   *phaseNames;      /* [numberPhases*nCh]                             */
+  double *phaseProperties; /* [numberPhases*(14+nc)]                         */
+  int    *phaseIndices;    /* [numberPhases]                                 */
+} NodeMemo;
+
 typedef struct _nodeList {
   int node;
-  SilminState *silminState;
+  int mode;
+  int converged; /* TRUE if the last equilibration of the node succeeded */
+  NodeMemo *memo;
+  SilminState *silminState;      /* NULL while the node is held compact      */
+  struct _compactState *compact; /* the node's state while it is idle        */
+  struct _nodeList *older, *newer; /* order of last use, for eviction */
 } NodeList;
-static NodeList *nodeList;
+
+/* Idle nodes may be held in a compact form (see meltssetcompactnodes_),
+   packed by packSilminState() into one buffer (see silmin.h).            */
+
+/* Nodes are registered in an open addressing hash table (linear probing)
+   of pointers to separately allocated entries, which therefore stay put.   */
+static NodeList **nodeTable;
+static int nodeTableSize;
 static int numberNodes;
+static int maxNodes; /* evict the least recently used node beyond this; 0 for no limit */
+static NodeList *oldestNode, *newestNode;
+static NodeList *activeNode; /* node whose state silminState points to */
+static int compactNodes;     /* TRUE to hold idle nodes compact          */
+
+static int    memoEnabled   = FALSE;
+static double memoTolerance = 0.0;
+static int    memoHits      = 0;
+static int    memoMisses    = 0;
+
+static int memoEqual(double a, double b) {
+  return (a == b) || (fabs(a-b) <= memoTolerance*MAX(fabs(a), fabs(b)));
+}
+
+static int memoMatches(NodeMemo *memo, int mode, int output, int nCh, double pressure,
+                       double temperature, double enthalpy, double *bulkComposition) {
+  int i;
+  if (memo == NULL || !memo->valid) return FALSE;
+  if ((memo->mode != mode) || (memo->output != output) || (memo->nCh != nCh)) return FALSE;
+  if ((memo->fo2Path != silminState->fo2Path) || (memo->fo2Delta != silminState->fo2Delta)) return FALSE;
+  if (!memoEqual(memo->pressure, pressure) || !memoEqual(memo->temperature, temperature)) return FALSE;
+  if ((mode > 1) && !memoEqual(memo->enthalpy, enthalpy)) return FALSE; /* H, S or V target */
+  for (i=0; i<nc; i++) if (!memoEqual(memo->bulkIn[i], bulkComposition[i])) return FALSE;
+  return TRUE;
+}
+
+static void invalidateMemo(NodeList *node) {
+  if (node != NULL && node->memo != NULL) node->memo->valid = FALSE;
+}
+
+/* The state of the node has been changed outside meltsprocess_(), so it is
+   neither the result memoized nor an equilibrium to warm-start from        */
+static void invalidateNode(NodeList *node) {
+  if (node == NULL) return;
+  node->converged = FALSE;
+  invalidateMemo(node);
+}
+
+static void storeMemo(NodeList *node, int mode, int output, int nCh, double pressure, double temperature,
+                      double enthalpy, double *bulkIn, int status, int numberPhases, double pressureOut,
+                      double temperatureOut, double enthalpyOut, double *bulkOut, char *phaseNames,
+                      double *phaseProperties, int *phaseIndices) {
+  NodeMemo *memo = node->memo;
+  int columnLength = 11 + nc + 3;
+
+  if (memo == NULL) {
+    memo = node->memo = (NodeMemo *) calloc((size_t) 1, sizeof(NodeMemo));
+    memo->bulkIn  = (double *) malloc((size_t) nc*sizeof(double));
+    memo->bulkOut = (double *) malloc((size_t) nc*sizeof(double));
+  }
+  memo->phaseNames      = (char *)   realloc(memo->phaseNames, (size_t) numberPhases*nCh*sizeof(char));
+  memo->phaseProperties = (double *) realloc(memo->phaseProperties, (size_t) numberPhases*columnLength*sizeof(double));
+  memo->phaseIndices    = (int *)    realloc(memo->phaseIndices, (size_t) numberPhases*sizeof(int));
+
+  memo->mode           = mode;
+  memo->output         = output;
+  memo->nCh            = nCh;
+  memo->fo2Path        = silminState->fo2Path;
+  memo->fo2Delta       = silminState->fo2Delta;
+  memo->pressure       = pressure;
+  memo->temperature    = temperature;
+  memo->enthalpy       = enthalpy;
+  memo->status         = status;
+  memo->numberPhases   = numberPhases;
+  memo->pressureOut    = pressureOut;
+  memo->temperatureOut = temperatureOut;
+  memo->enthalpyOut    = enthalpyOut;
+  memcpy(memo->bulkIn,  bulkIn,  (size_t) nc*sizeof(double));
+  memcpy(memo->bulkOut, bulkOut, (size_t) nc*sizeof(double));
+  memcpy(memo->phaseNames, phaseNames, (size_t) numberPhases*nCh*sizeof(char));
+  memcpy(memo->phaseProperties, phaseProperties, (size_t) numberPhases*columnLength*sizeof(double));
+  memcpy(memo->phaseIndices, phaseIndices, (size_t) numberPhases*sizeof(int));
+  memo->valid = TRUE;
+}
+
+static unsigned int hashNode(int node) {
+  return (((unsigned int) node)*2654435761u) & ((unsigned int) nodeTableSize - 1);
+}
+
+static void unlinkNode(NodeList *entry) {
+  if (entry->older != NULL) entry->older->newer = entry->newer; else oldestNode = entry->newer;
+  if (entry->newer != NULL) entry->newer->older = entry->older; else newestNode = entry->older;
+  entry->older = entry->newer = NULL;
+}
+
+static void linkNewestNode(NodeList *entry) {
+  entry->older = newestNode;
+  entry->newer = NULL;
+  if (newestNode != NULL) newestNode->newer = entry; else oldestNode = entry;
+  newestNode = entry;
+}
+
+static void freeMemo(NodeMemo *memo) {
+  if (memo == NULL) return;
+  free(memo->bulkIn);
+  free(memo->bulkOut);
+  free(memo->phaseNames);
+  free(memo->phaseProperties);
+  free(memo->phaseIndices);
+  free(memo);
+}
+
+/* destroySilminStateStructure() leaves the optional arrays to the caller */
+static void destroyNodeState(SilminState *p) {
+  int i;
+
+  if (p->fracSComp != NULL) {
+    for (i=0; i<npc; i++) free((p->fracSComp)[i]);
+    free(p->fracSComp);
+    free(p->nFracCoexist);
+  }
+  free(p->fracLComp);
+  free(p->ySol);
+  free(p->yLiq);
+  destroySilminStateStructure(p);
+}
+
+/* Returns the entry for node, or NULL if it is not registered */
+static NodeList *findNode(int node) {
+  unsigned int i;
+  NodeList *entry;
+
+  if (numberNodes == 0) return NULL;
+  for (i=hashNode(node); (entry = nodeTable[i]) != NULL; i=(i+1) & (nodeTableSize-1)) if (entry->node == node) {
+    if (entry != newestNode) { unlinkNode(entry); linkNewestNode(entry); }
+    return entry;
+  }
+  return NULL;
+}
+
+static void removeNode(NodeList *entry) {
+  unsigned int i, j, k, mask = (unsigned int) nodeTableSize - 1;
+
+  for (i=hashNode(entry->node); nodeTable[i] != entry; i=(i+1) & mask);
+  nodeTable[i] = NULL;
+  /* close the gap left in the probe sequence of the entries that follow */
+  for (j=(i+1) & mask; nodeTable[j] != NULL; j=(j+1) & mask) {
+    k = hashNode(nodeTable[j]->node);
+    if ((j > i) ? ((k <= i) || (k > j)) : ((k <= i) && (k > j))) {
+      nodeTable[i] = nodeTable[j];
+      nodeTable[j] = NULL;
+      i = j;
+    }
+  }
+  unlinkNode(entry);
+  numberNodes--;
+
+  if (activeNode == entry) activeNode = NULL;
+  if (entry->silminState != NULL) {
+    if (silminState == entry->silminState) silminState = NULL;
+    if (entry->mode != calculationMode) { /* the state is sized for its own model */
+      int mode = calculationMode;
+      selectModel(entry->mode);
+      destroyNodeState(entry->silminState);
+      selectModel(mode);
+    } else destroyNodeState(entry->silminState);
+  }
+  free(entry->compact);
+  freeMemo(entry->memo);
+  free(entry);
+}
+
+/* Returns the entry for node, registering it with a new state in the current
+   calculation mode if need be; *created is set TRUE if so                   */
+static NodeList *registerNode(int node, int *created) {
+  NodeList *entry = findNode(node);
+  unsigned int i;
+
+  *created = (entry == NULL);
+  if (entry != NULL) return entry;
+
+  if (4*(numberNodes+1) > 3*nodeTableSize) {
+    NodeList **oldTable = nodeTable;
+    int oldSize = nodeTableSize;
+    nodeTableSize = (nodeTableSize == 0) ? 64 : 2*nodeTableSize;
+    nodeTable = (NodeList **) calloc((size_t) nodeTableSize, sizeof(NodeList *));
+    for (i=0; i<(unsigned int) oldSize; i++) if (oldTable[i] != NULL) {
+      unsigned int j;
+      for (j=hashNode(oldTable[i]->node); nodeTable[j] != NULL; j=(j+1) & (nodeTableSize-1));
+      nodeTable[j] = oldTable[i];
+    }
+    free(oldTable);
+  }
+
+  entry = (NodeList *) calloc((size_t) 1, sizeof(NodeList));
+  entry->node        = node;
+  entry->mode        = calculationMode;
+  entry->converged   = FALSE;
+  entry->memo        = NULL;
+  entry->silminState = createSilminState();
+  for (i=hashNode(node); nodeTable[i] != NULL; i=(i+1) & (nodeTableSize-1));
+  nodeTable[i] = entry;
+  linkNewestNode(entry);
+  numberNodes++;
+
+  if ((maxNodes > 0) && (numberNodes > maxNodes)) removeNode(oldestNode);
+  return entry;
+}
+
+/* Holds an idle node compact; its state is packed under its own model */
+static void compactNode(NodeList *entry) {
+  int mode = calculationMode;
+
+  if ((entry->silminState == NULL) || (entry->silminState->assimilate)) return;
+  if (entry->mode != mode) selectModel(entry->mode);
+  if ((entry->compact = packSilminState(entry->silminState)) != NULL) {
+    if (silminState == entry->silminState) silminState = NULL;
+    destroyNodeState(entry->silminState);
+    entry->silminState = NULL;
+  }
+  if (entry->mode != mode) selectModel(mode);
+}
+
+/* Selects the model and state of a node for a calculation, first packing
+   the previous node if idle nodes are held compact                      */
+static void activateNode(NodeList *entry) {
+  if (compactNodes && (activeNode != NULL) && (activeNode != entry)) compactNode(activeNode);
+  selectModel(entry->mode);
+  if (entry->silminState == NULL) {
+    entry->silminState = unpackSilminState(entry->compact);
+    free(entry->compact);
+    entry->compact = NULL;
+  }
+  silminState = entry->silminState;
+  activeNode  = entry;
+}
+
+/* Bytes held by a full state of the current model, excluding allocator overhead */
+static size_t stateBytes(SilminState *p) {
+  size_t bytes = sizeof(SilminState);
+  int i, k, ns;
+
+  bytes += 2*nc*sizeof(double) + (size_t) MAX(1, p->nLiquidCoexist)*(2*sizeof(double *) + 2*nlc*sizeof(double));
+  bytes += 2*npc*sizeof(double *) + (3*npc+1)*sizeof(int);
+  for (i=0; i<npc; i++) {
+    if (((ns = (p->nSolidCoexist)[i]) > 0) && (solids[i].type == PHASE)) {
+      k = (solids[i].na > 1) ? solids[i].na : 0;
+      bytes += (size_t) (1+k)*2*ns*sizeof(double);
+      i += k;
+    } else bytes += 2*sizeof(double);
+  }
+  if (p->fracSComp != NULL) {
+    bytes += npc*(sizeof(double *) + sizeof(int));
+    for (i=0; i<npc; i++) if ((ns = (p->nFracCoexist)[i]) > 0)
+      bytes += (size_t) ((solids[i].na > 1) ? 1+solids[i].na : 1)*ns*sizeof(double);
+  }
+  if (p->fracLComp != NULL) bytes += nlc*sizeof(double);
+  if (p->ySol != NULL) bytes += (npc+nlc)*sizeof(double);
+  return bytes;
+}
+
+/* T (K) and P (bars) at which the end-member properties in liquid[].cur and
+   solids[].cur were last evaluated by silmin(); zero if unknown */
+static double thermoDataT = 0.0;
+static double thermoDataP = 0.0;
 
-static int compareNodes(const void *aPt, const void *bPt) {
-  NodeList *a = (NodeList *) aPt;
-  NodeList *b = (NodeList *) bPt;
-  return (a->node - b->node);
+static void saveModel(void) {
+  currentModel->oxygen    = oxygen;
+  currentModel->phaseList = phaseList;
+  currentModel->np        = np;
+}
+
+static void restoreModel(MeltsModel *model) {
+  int i;
+  liquid    = model->liquid;
+  solids    = model->solids;
+  nlc       = model->nlc;
+  nls       = model->nls;
+  npc       = model->npc;
+  oxygen    = model->oxygen;
+  for (i=0; i<nc; i++) bulkSystem[i].oxToLiq = (model->oxToLiq)[i];
+  phaseList = model->phaseList;
+  np        = model->np;
+  thermoDataT = 0.0; /* liquid[].cur and solids[].cur belong to the new tables */
+  thermoDataP = 0.0;
 }
 
 static SilminState *createSilminState(void) {
@@ -592,6 +999,291 @@ void getMeltsViscosity(int *failure, char *model, double *temperature, double *b
 #endif  
 }
 
+/* ================================================================================== */
+/* Loads the properties of the system and of every phase present in the current      */
+/* silminState into phaseNames, phaseProperties and phaseIndices (layout as described */
+/* for meltsprocess_ below). Uses the end-member properties in liquid[].cur and       */
+/* solids[].cur, which must be evaluated at silminState->T and silminState->P.        */
+/* Returns the system enthalpy, entropy and volume (J/bar) in hTot, sTot and vTot.     */
+/* ================================================================================== */
+
+static void loadPhaseProperties(char phaseNames[], int nCh, int *numberPhases, double *phaseProperties,
+                                int phaseIndices[], double *hTot, double *sTot, double *vTot) {
+  double gLiq = 0.0, hLiq = 0.0, sLiq = 0.0, vLiq = 0.0, cpLiq = 0.0, dcpdtLiq = 0.0, 
+         dvdtLiq = 0.0, dvdpLiq = 0.0, d2vdt2Liq = 0.0, d2vdtdpLiq = 0.0, d2vdp2Liq = 0.0;
+  double totalG=0.0, totalH=0.0, totalS=0.0, totalV=0.0, totalCp=0.0, totaldCpdT=0.0, 
+         totaldVdT=0.0, totaldVdP=0.0, totald2VdT2=0.0, totald2VdTdP=0.0, totald2VdP2=0.0, totalGrams, totalMoles;
+  static double *m, *r, *oxVal;
+  int i, j;
+  int columnLength = 11 + nc + 3; /* G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2, + nc oxides + volume fraction, density, viscosity */
+
+#ifdef TESTDYNAMICLIB
+  strncpy(phaseNames, "bulk", nCh);
+  *numberPhases = 1;
+  phaseIndices[0] = -10;
+#else
+  strncpy(phaseNames, "system", nCh);
+  *numberPhases = 1;
+  phaseIndices[0] = 1;
+#endif
+
+  if (m == NULL)       m = (double *) malloc((size_t)      nc*sizeof(double));
+  if (r == NULL)       r = (double *) malloc((size_t) (nlc-1)*sizeof(double));
+  if (oxVal == NULL) oxVal = (double *) malloc((size_t)      nc*sizeof(double));
+  
+  /* liquid is the second "phase" reported */
+  if (silminState->liquidMass != 0.0) {
+    int nl;
+    double gramTot=0.0, mTot = 0.0;
+    strncpy(phaseNames + sizeof(char)*nCh, "liquid", nCh);
+#ifdef TESTDYNAMICLIB
+    /* multiple liquids not actually allowed yet... */
+    *numberPhases = silminState->nLiquidCoexist + 1;
+    phaseIndices[1] = 0; // set within nl loop
+#else
+    *numberPhases = 2;
+    phaseIndices[1] = 2;      
+#endif
+
+    for (i=0; i<nc; i++) oxVal[i]=0.0;
+  
+    for (nl=0; nl<silminState->nLiquidCoexist; nl++) {
+      double moles;
+      double G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2;
+  
+      conLiq(SECOND, THIRD, silminState->T, silminState->P, NULL, silminState->liquidComp[nl], r, NULL, NULL, NULL, NULL);
+
+      gmixLiq (FIRST, silminState->T, silminState->P, r, &G, NULL, NULL);
+      hmixLiq (FIRST, silminState->T, silminState->P, r, &H, NULL);
+      smixLiq (FIRST, silminState->T, silminState->P, r, &S, NULL, NULL, NULL);
+      vmixLiq (FIRST | FOURTH | FIFTH | SIXTH | SEVENTH | EIGHTH, 
+      silminState->T, silminState->P, r, &V, NULL, NULL, &dVdT, &dVdP, &d2VdT2, &d2VdTdP, &d2VdP2, NULL, NULL, NULL);
+      cpmixLiq(FIRST | SECOND, 
+      silminState->T, silminState->P, r, &Cp, &dCpdT, NULL);
+
+      for (i=0, moles=0.0; i<nlc; i++) moles +=  (silminState->liquidComp)[nl][i];
+      G       *= moles; 
+      H       *= moles; 
+      S       *= moles;
+      V       *= moles; 
+      Cp      *= moles;
+      dCpdT   *= moles; 
+      dVdT    *= moles; 
+      dVdP    *= moles; 
+      d2VdT2  *= moles; 
+      d2VdTdP *= moles; 
+      d2VdP2  *= moles;
+
+      for (i=0; i<nlc; i++) {
+        G       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).g;
+        H       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).h;
+        S       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).s;
+        V       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).v;
+        Cp      += (silminState->liquidComp)[nl][i]*(liquid[i].cur).cp;
+        dCpdT   += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dcpdt;
+        dVdT    += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dvdt;
+        dVdP    += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dvdp;
+        d2VdT2  += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdt2;
+        d2VdTdP += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdtdp;
+        d2VdP2  += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdp2;
+      }
+
+      for (i=0; i<nc; i++) {
+        for (j=0; j<nlc; j++) oxVal[i] += (liquid[j].liqToOx)[i]*(silminState->liquidComp)[nl][j]*bulkSystem[i].mw;
+        gramTot += oxVal[i];
+      }
+      mTot += moles;
+
+      gLiq    += G;    hLiq    += H;    sLiq      += S;      vLiq    += V;       cpLiq     += Cp;     dcpdtLiq += dCpdT; 
+      dvdtLiq += dVdT; dvdpLiq += dVdP; d2vdt2Liq += d2VdT2; d2vdtdpLiq += d2VdTdP; d2vdp2Liq += d2VdP2;
+  
+    } /* end loop over all liquids */
+    
+    phaseProperties[columnLength+ 0] = gLiq;
+    phaseProperties[columnLength+ 1] = hLiq;
+    phaseProperties[columnLength+ 2] = sLiq;
+    phaseProperties[columnLength+ 3] = vLiq*10.0;
+    phaseProperties[columnLength+ 4] = cpLiq;
+    phaseProperties[columnLength+ 5] = dcpdtLiq;
+    phaseProperties[columnLength+ 6] = dvdtLiq*10.0;
+    phaseProperties[columnLength+ 7] = dvdpLiq*10.0;
+    phaseProperties[columnLength+ 8] = d2vdt2Liq*10.0;
+    phaseProperties[columnLength+ 9] = d2vdtdpLiq*10.0;
+    phaseProperties[columnLength+10] = d2vdp2Liq*10.0;
+    for (i=0; i<nc; i++) phaseProperties[columnLength+11+i] = oxVal[i]; 
+#ifndef TESTDYNAMICLIB
+    phaseProperties[columnLength+11+nc  ] = vLiq*10.0;
+    phaseProperties[columnLength+11+nc+1] = (vLiq != 0.0) ? 100.0*gramTot/vLiq : 0.0;
+    phaseProperties[columnLength+11+nc+2] = viscosityFromGRD(silminState->T, oxVal);
+#else
+    phaseProperties[columnLength+11+nc  ] = (mTot != 0.0) ? gramTot/mTot : 0.0;
+    phaseProperties[columnLength+11+nc+1] = (vLiq != 0.0) ? 100.0*gramTot/vLiq : 0.0;
+    //phaseProperties[columnLength+11+nc+2] = gramTot;
+    phaseProperties[columnLength+11+nc+2] = viscosityFromShaw(silminState->T, oxVal);
+#endif
+  } /* end liquid block */
+
+  /* begin solid block */
+  for (j=0; j<npc; j++) {
+    int ns;
+    for (ns=0; ns<(silminState->nSolidCoexist)[j]; ns++) {
+      double G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2, gramTot=0.0, mTot = 0.0;
+   
+      if (solids[j].na == 1) {
+        G       = (silminState->solidComp)[j][ns]*(solids[j].cur).g;
+        H       = (silminState->solidComp)[j][ns]*(solids[j].cur).h;
+        S       = (silminState->solidComp)[j][ns]*(solids[j].cur).s;
+        V       = (silminState->solidComp)[j][ns]*(solids[j].cur).v;
+        Cp      = (silminState->solidComp)[j][ns]*(solids[j].cur).cp;
+        dCpdT   = (silminState->solidComp)[j][ns]*(solids[j].cur).dcpdt;
+        dVdT    = (silminState->solidComp)[j][ns]*(solids[j].cur).dvdt;
+        dVdP    = (silminState->solidComp)[j][ns]*(solids[j].cur).dvdp;
+        d2VdT2  = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdt2;
+        d2VdTdP = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdtdp;
+        d2VdP2  = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdp2;
+
+        totalG       += (silminState->solidComp)[j][ns]*(solids[j].cur).g;
+        totalH       += (silminState->solidComp)[j][ns]*(solids[j].cur).h;
+        totalS       += (silminState->solidComp)[j][ns]*(solids[j].cur).s;
+        totalV       += (silminState->solidComp)[j][ns]*(solids[j].cur).v;
+        totalCp      += (silminState->solidComp)[j][ns]*(solids[j].cur).cp;
+        totaldCpdT   += (silminState->solidComp)[j][ns]*(solids[j].cur).dcpdt;
+        totaldVdT    += (silminState->solidComp)[j][ns]*(solids[j].cur).dvdt;
+        totaldVdP    += (silminState->solidComp)[j][ns]*(solids[j].cur).dvdp;
+        totald2VdT2  += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdt2;
+        totald2VdTdP += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdtdp;
+        totald2VdP2  += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdp2;
+    
+        for (i=0; i<nc; i++) {
+          oxVal[i] = (solids[j].solToOx)[i]*bulkSystem[i].mw*(silminState->solidComp)[j][ns];
+          gramTot += oxVal[i];
+        }
+        mTot = (silminState->solidComp)[j][ns];
+    
+      } else {
+        for (i=0; i<solids[j].na; i++) m[i] = (silminState->solidComp)[j+1+i][ns];
+
+        (*solids[j].convert)(SECOND, THIRD, silminState->T, silminState->P, NULL, m, r, NULL, NULL, NULL, NULL, NULL);
+        (*solids[j].gmix) (FIRST, silminState->T, silminState->P, r, &G, NULL, NULL, NULL);
+        (*solids[j].hmix) (FIRST, silminState->T, silminState->P, r, &H);
+        (*solids[j].smix) (FIRST, silminState->T, silminState->P, r, &S, NULL, NULL);
+        (*solids[j].vmix) (FIRST | FOURTH | FIFTH | SIXTH | SEVENTH | EIGHTH, 
+        silminState->T, silminState->P, r, &V, NULL, NULL, &dVdT, &dVdP, &d2VdT2, &d2VdTdP, &d2VdP2, NULL, NULL);
+        (*solids[j].cpmix)(FIRST | SECOND, silminState->T, silminState->P, r, &Cp, &dCpdT, NULL);
+
+        G       *= (silminState->solidComp)[j][ns];
+        H       *= (silminState->solidComp)[j][ns]; 
+        S       *= (silminState->solidComp)[j][ns];
+        V       *= (silminState->solidComp)[j][ns];
+        Cp      *= (silminState->solidComp)[j][ns];
+        dCpdT   *= (silminState->solidComp)[j][ns];
+        dVdT    *= (silminState->solidComp)[j][ns];
+        dVdP    *= (silminState->solidComp)[j][ns];
+        d2VdT2  *= (silminState->solidComp)[j][ns];
+        d2VdTdP *= (silminState->solidComp)[j][ns];
+        d2VdP2  *= (silminState->solidComp)[j][ns];
+    
+        for (i=0; i<solids[j].na; i++) {
+          G       += m[i]*(solids[j+1+i].cur).g;
+          H       += m[i]*(solids[j+1+i].cur).h;
+          S       += m[i]*(solids[j+1+i].cur).s;
+          V       += m[i]*(solids[j+1+i].cur).v;
+          Cp      += m[i]*(solids[j+1+i].cur).cp;
+          dCpdT   += m[i]*(solids[j+1+i].cur).dcpdt;
+          dVdT    += m[i]*(solids[j+1+i].cur).dvdt;
+          dVdP    += m[i]*(solids[j+1+i].cur).dvdp;
+          d2VdT2  += m[i]*(solids[j+1+i].cur).d2vdt2;
+          d2VdTdP += m[i]*(solids[j+1+i].cur).d2vdtdp;
+          d2VdP2  += m[i]*(solids[j+1+i].cur).d2vdp2;
+        }
+
+        totalG       += G;
+        totalH       += H;
+        totalS       += S;
+        totalV       += V;
+        totalCp      += Cp;
+        totaldCpdT   += dCpdT;
+        totaldVdT    += dVdT;
+        totaldVdP    += dVdP;
+        totald2VdT2  += d2VdT2;
+        totald2VdTdP += d2VdTdP;
+        totald2VdP2  += d2VdP2;
+    
+        for (i=0; i<nc; i++) {
+          int k;
+          for (k=0, oxVal[i]=0.0; k<solids[j].na; k++) oxVal[i] += (solids[j+1+k].solToOx)[i]*m[k]*bulkSystem[i].mw;
+          gramTot += oxVal[i];
+        }
+        for (i=0; i<solids[j].na; i++) mTot += m[i];
+      }
+
+      phaseProperties[(*numberPhases)*columnLength+ 0] = G;
+      phaseProperties[(*numberPhases)*columnLength+ 1] = H;
+      phaseProperties[(*numberPhases)*columnLength+ 2] = S;
+      phaseProperties[(*numberPhases)*columnLength+ 3] = V*10.0;
+      phaseProperties[(*numberPhases)*columnLength+ 4] = Cp;
+      phaseProperties[(*numberPhases)*columnLength+ 5] = dCpdT;
+      phaseProperties[(*numberPhases)*columnLength+ 6] = dVdT*10.0;
+      phaseProperties[(*numberPhases)*columnLength+ 7] = dVdP*10.0;
+      phaseProperties[(*numberPhases)*columnLength+ 8] = d2VdT2*10.0;
+      phaseProperties[(*numberPhases)*columnLength+ 9] = d2VdTdP*10.0;
+      phaseProperties[(*numberPhases)*columnLength+10] = d2VdP2*10.0;
+      for (i=0; i<nc; i++) phaseProperties[(*numberPhases)*columnLength+11+i] = oxVal[i]; 
+#ifndef TESTDYNAMICLIB
+      phaseProperties[(*numberPhases)*columnLength+11+nc  ] = V*10.0;
+      phaseProperties[(*numberPhases)*columnLength+11+nc+1] = (V != 0.0) ? 100.0*gramTot/V : 0.0;
+      phaseProperties[(*numberPhases)*columnLength+11+nc+2] = 0.0;
+#else
+      phaseProperties[(*numberPhases)*columnLength+11+nc  ] = (mTot != 0.0) ? gramTot/mTot : 0.0;
+      phaseProperties[(*numberPhases)*columnLength+11+nc+1] = (V != 0.0) ? 100.0*gramTot/V : 0.0;
+      phaseProperties[(*numberPhases)*columnLength+11+nc+2] = gramTot;
+#endif
+  
+      strncpy(phaseNames+(*numberPhases)*sizeof(char)*nCh,solids[j].label, nCh);
+      phaseIndices[(*numberPhases)] = j*10 + ns + 10;
+      (*numberPhases)++;
+  
+    } /* end loop on ns */
+  }  /* end loop on j */
+  /* end solid block */
+
+  /* system poperties */
+  phaseProperties[ 0] = gLiq + totalG;
+  phaseProperties[ 1] = hLiq + totalH;
+  phaseProperties[ 2] = sLiq + totalS;
+  phaseProperties[ 3] = (vLiq + totalV)*10.0;
+  phaseProperties[ 4] = cpLiq + totalCp;
+  phaseProperties[ 5] = dcpdtLiq + totaldCpdT;
+  phaseProperties[ 6] = (dvdtLiq + totaldVdT)*10.0;
+  phaseProperties[ 7] = (dvdpLiq + totaldVdP)*10.0;
+  phaseProperties[ 8] = (d2vdt2Liq + totald2VdT2)*10.0;
+  phaseProperties[ 9] = (d2vdtdpLiq + totald2VdTdP)*10.0;
+  phaseProperties[10] = (d2vdp2Liq + totald2VdP2)*10.0;
+  for (i=0, totalGrams=0.0, totalMoles = 0.0; i<nc; i++) {
+    phaseProperties[11+i] = (silminState->bulkComp)[i]*bulkSystem[i].mw;
+    totalGrams += phaseProperties[11+i];
+    totalMoles += (silminState->bulkComp)[i];
+  }
+#ifndef TESTDYNAMICLIB
+  phaseProperties[11+nc  ] = 1.0;
+  phaseProperties[11+nc+1] = ((vLiq+totalV) != 0.0) ? 100.0*totalGrams/(vLiq+totalV) : 0.0;
+  phaseProperties[11+nc+2] = 0.0;
+#else
+  phaseProperties[11+nc  ] = (totalMoles != 0.0) ? totalGrams/totalMoles : 0.0;
+  phaseProperties[11+nc+1] = ((vLiq+totalV) != 0.0) ? 100.0*totalGrams/(vLiq+totalV) : 0.0;
+  //phaseProperties[11+nc+2] = totalGrams;
+  phaseProperties[11+nc+2] = silminState->fo2;
+#endif
+
+#ifndef TESTDYNAMICLIB
+  if ((vLiq+totalV) != 0.0) for (i=1; i<=(*numberPhases); i++) phaseProperties[i*columnLength+11+nc] /= 10.0*(vLiq+totalV);
+#endif
+
+  *hTot = hLiq + totalH;
+  *sTot = sLiq + totalS;
+  *vTot = vLiq + totalV;
+}
+
 /* ================================================================================== */
 /* MELTS processing call                                                              */
 /* Input:                                                                             */
@@ -647,10 +1339,14 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
          double *enthalpy, double *temperature, 
            char phaseNames[], int *nCharInName, int *numberPhases, int *iterations, int *status, 
            double *phaseProperties, int phaseIndices[]) {
-  int update = FALSE;
+  int update = FALSE, warmStart = FALSE;
   int nCh = *nCharInName, output = 0;
   int fractionateSol, fractionateFlu, fractionateLiq; 
   double *entropy = enthalpy, *volume = enthalpy;
+  double pressureIn = *pressure, temperatureIn = *temperature, enthalpyIn = *enthalpy;
+  static double *bulkIn = NULL;
+  NodeList *thisNode;
+  int created;
   if (!iAmInitialized) initializeLibrary();
 
   /* Set output = 0 for properties to return after equilibration (like alphaMELTS menu option 3) */
@@ -662,44 +1358,61 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
 #ifdef TESTDYNAMICLIB
   output = *iterations;
 #endif
+
+  /* For backwards compatibility if not coming from PyMELTS or Matlab: */
+  /* Previously mode = 0 was isenthalpic, rather than 'find liquidus', */
+  /* but this should only have been invoked with non-zero enthalpy.    */
+#ifndef TESTDYNAMICLIB
+  if (*mode == 0 && *enthalpy != 0.0) *mode = 2;
+#endif
+
+  if (memoEnabled) {
+    if (bulkIn == NULL) bulkIn = (double *) malloc((size_t) nc*sizeof(double));
+    memcpy(bulkIn, bulkComposition, (size_t) nc*sizeof(double));
+  }
   
-  if (numberNodes != 0) {
-    NodeList key, *res;
-    key.node = *nodeIndex;
-    res = bsearch(&key, nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    if (res == NULL) {
-      numberNodes++;
-      nodeList = (NodeList *) realloc(nodeList, (size_t) numberNodes*sizeof(struct _nodeList));
-      (nodeList[numberNodes-1]).silminState = createSilminState();
-      (nodeList[numberNodes-1]).node = *nodeIndex;
-      silminState = (nodeList[numberNodes-1]).silminState;
-      qsort(nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    } else { 
-      int i;
-      silminState = res->silminState;
-      for(i=0; i<nc; i++) {
-        if((silminState->bulkComp)[i] != 0.0) {
-          update = TRUE;
-          break;
-        }
+  thisNode = registerNode(*nodeIndex, &created);
+  activateNode(thisNode);
+  if (!created) {
+    int i;
+    if (memoEnabled && memoMatches(thisNode->memo, *mode, output, nCh, *pressure, *temperature, *enthalpy, bulkComposition)) {
+      NodeMemo *memo = thisNode->memo;
+      memcpy(phaseNames, memo->phaseNames, (size_t) memo->numberPhases*nCh*sizeof(char));
+      memcpy(phaseProperties, memo->phaseProperties, (size_t) memo->numberPhases*(11+nc+3)*sizeof(double));
+      memcpy(phaseIndices, memo->phaseIndices, (size_t) memo->numberPhases*sizeof(int));
+      memcpy(bulkComposition, memo->bulkOut, (size_t) nc*sizeof(double));
+      *numberPhases = memo->numberPhases;
+      *status       = memo->status;
+      *pressure     = memo->pressureOut;
+      *temperature  = memo->temperatureOut;
+      *enthalpy     = memo->enthalpyOut;
+      *iterations   = -1;
+      memoHits++;
+      return;
+    }
+    for(i=0; i<nc; i++) {
+      if((silminState->bulkComp)[i] != 0.0) {
+        update = TRUE;
+        break;
       }
-    } 
-  } else {
-    numberNodes = 1;
-    nodeList = (NodeList *) realloc(nodeList, sizeof(struct _nodeList));
-    (nodeList[0]).silminState = createSilminState();
-    (nodeList[0]).node = *nodeIndex;
-    silminState = (nodeList[0]).silminState;
+    }
+    warmStart = update && thisNode->converged && (*mode == 1)
+      && (silminState->T == *temperature) && (silminState->P == *pressure);
   }
-  
+
   if (update) {
     int i, j;
     static double *changeBC = NULL;
+    double massChange = 0.0, mass = 0.0;
     if (changeBC == NULL) changeBC = (double *) malloc((size_t) nc*sizeof(double));
     for (i=0; i<nc; i++) {
       changeBC[i] = bulkComposition[i]/bulkSystem[i].mw - (silminState->bulkComp)[i];
       silminState->liquidMass += bulkComposition[i] - (silminState->bulkComp)[i]*bulkSystem[i].mw;
+      massChange += fabs(changeBC[i])*bulkSystem[i].mw;
+      mass       += bulkComposition[i];
     }
+    /* A small change at fixed T and P keeps the converged assemblage (see meltsWarmStart) */
+    if (massChange > WARM_START_MAX_CHANGE*mass) warmStart = FALSE;
     for (i=0; i<nc; i++) (silminState->bulkComp)[i] += changeBC[i];
     for (i=0; i<nlc; i++) {
       for (j=0; j<nc; j++) {
@@ -731,13 +1444,6 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
   silminState->P           = *pressure;  
   silminState->dspPstart   = *pressure;  
   silminState->dspPstop    = *pressure;
-
-  /* For backwards compatibility if not coming from PyMELTS or Matlab: */
-  /* Previously mode = 0 was isenthalpic, rather than 'find liquidus', */
-  /* but this should only have been invoked with non-zero enthalpy.    */
-#ifndef TESTDYNAMICLIB
-  if (*mode == 0 && *enthalpy != 0.0) *mode = 2;
-#endif
   
   switch (*mode) {
   case 2:
@@ -795,21 +1501,18 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
     silminState->fractionateLiq = FALSE;
   }
   
-  if (*mode)
+  if (*mode) {
+    meltsWarmStart = warmStart;
     while(!silmin());
-  else
+    thermoDataT = silminState->T;
+    thermoDataP = silminState->P;
+  } else {
     while(!liquidus());
+    thermoDataT = 0.0;
+    thermoDataP = 0.0;
+  }
+  thisNode->converged = (*mode != 0) && (meltsStatus.status == SILMIN_SUCCESS);
   
-#ifdef TESTDYNAMICLIB
-  strncpy(phaseNames, "bulk", nCh);
-  *numberPhases = 1;
-  phaseIndices[0] = -10;
-#else
-  strncpy(phaseNames, "system", nCh);
-  *numberPhases = 1;
-  phaseIndices[0] = 1;
-
-#endif
   *iterations = -1;
   
   switch (meltsStatus.status) {
@@ -864,265 +1567,10 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
   }
 
   { /* output block */
-    double gLiq = 0.0, hLiq = 0.0, sLiq = 0.0, vLiq = 0.0, cpLiq = 0.0, dcpdtLiq = 0.0, 
-           dvdtLiq = 0.0, dvdpLiq = 0.0, d2vdt2Liq = 0.0, d2vdtdpLiq = 0.0, d2vdp2Liq = 0.0;
-    double totalG=0.0, totalH=0.0, totalS=0.0, totalV=0.0, totalCp=0.0, totaldCpdT=0.0, 
-           totaldVdT=0.0, totaldVdP=0.0, totald2VdT2=0.0, totald2VdTdP=0.0, totald2VdP2=0.0, totalGrams, totalMoles;
-    static double *m, *r, *oxVal;
-    int i, j;
-    int columnLength = 11 + nc + 3; /* G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2, + nc oxides + volume fraction, density, viscosity */
-    
-    if (m == NULL)       m = (double *) malloc((size_t)      nc*sizeof(double));
-    if (r == NULL)       r = (double *) malloc((size_t) (nlc-1)*sizeof(double));
-    if (oxVal == NULL) oxVal = (double *) malloc((size_t)      nc*sizeof(double));
-    
-    /* liquid is the second "phase" reported */
-    if (silminState->liquidMass != 0.0) {
-      int nl;
-      double gramTot=0.0, mTot = 0.0;
-      strncpy(phaseNames + sizeof(char)*nCh, "liquid", nCh);
-#ifdef TESTDYNAMICLIB
-      /* multiple liquids not actually allowed yet... */
-      *numberPhases = silminState->nLiquidCoexist + 1;
-      phaseIndices[1] = 0; // set within nl loop
-#else
-      *numberPhases = 2;
-      phaseIndices[1] = 2;      
-#endif
-
-      for (i=0; i<nc; i++) oxVal[i]=0.0;
-    
-      for (nl=0; nl<silminState->nLiquidCoexist; nl++) {
-        double moles;
-        double G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2;
-    
-        conLiq(SECOND, THIRD, silminState->T, silminState->P, NULL, silminState->liquidComp[nl], r, NULL, NULL, NULL, NULL);
-
-        gmixLiq (FIRST, silminState->T, silminState->P, r, &G, NULL, NULL);
-        hmixLiq (FIRST, silminState->T, silminState->P, r, &H, NULL);
-        smixLiq (FIRST, silminState->T, silminState->P, r, &S, NULL, NULL, NULL);
-        vmixLiq (FIRST | FOURTH | FIFTH | SIXTH | SEVENTH | EIGHTH, 
-        silminState->T, silminState->P, r, &V, NULL, NULL, &dVdT, &dVdP, &d2VdT2, &d2VdTdP, &d2VdP2, NULL, NULL, NULL);
-        cpmixLiq(FIRST | SECOND, 
-        silminState->T, silminState->P, r, &Cp, &dCpdT, NULL);
-
-        for (i=0, moles=0.0; i<nlc; i++) moles +=  (silminState->liquidComp)[nl][i];
-        G       *= moles; 
-        H       *= moles; 
-        S       *= moles;
-        V       *= moles; 
-        Cp      *= moles;
-        dCpdT   *= moles; 
-        dVdT    *= moles; 
-        dVdP    *= moles; 
-        d2VdT2  *= moles; 
-        d2VdTdP *= moles; 
-        d2VdP2  *= moles;
-
-        for (i=0; i<nlc; i++) {
-          G       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).g;
-          H       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).h;
-          S       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).s;
-          V       += (silminState->liquidComp)[nl][i]*(liquid[i].cur).v;
-          Cp      += (silminState->liquidComp)[nl][i]*(liquid[i].cur).cp;
-          dCpdT   += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dcpdt;
-          dVdT    += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dvdt;
-          dVdP    += (silminState->liquidComp)[nl][i]*(liquid[i].cur).dvdp;
-          d2VdT2  += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdt2;
-          d2VdTdP += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdtdp;
-          d2VdP2  += (silminState->liquidComp)[nl][i]*(liquid[i].cur).d2vdp2;
-        }
-
-        for (i=0; i<nc; i++) {
-          for (j=0; j<nlc; j++) oxVal[i] += (liquid[j].liqToOx)[i]*(silminState->liquidComp)[nl][j]*bulkSystem[i].mw;
-          gramTot += oxVal[i];
-        }
-        mTot += moles;
-
-        gLiq    += G;    hLiq    += H;    sLiq      += S;      vLiq    += V;       cpLiq     += Cp;     dcpdtLiq += dCpdT; 
-        dvdtLiq += dVdT; dvdpLiq += dVdP; d2vdt2Liq += d2VdT2; d2vdtdpLiq += d2VdTdP; d2vdp2Liq += d2VdP2;
-    
-      } /* end loop over all liquids */
-      
-      phaseProperties[columnLength+ 0] = gLiq;
-      phaseProperties[columnLength+ 1] = hLiq;
-      phaseProperties[columnLength+ 2] = sLiq;
-      phaseProperties[columnLength+ 3] = vLiq*10.0;
-      phaseProperties[columnLength+ 4] = cpLiq;
-      phaseProperties[columnLength+ 5] = dcpdtLiq;
-      phaseProperties[columnLength+ 6] = dvdtLiq*10.0;
-      phaseProperties[columnLength+ 7] = dvdpLiq*10.0;
-      phaseProperties[columnLength+ 8] = d2vdt2Liq*10.0;
-      phaseProperties[columnLength+ 9] = d2vdtdpLiq*10.0;
-      phaseProperties[columnLength+10] = d2vdp2Liq*10.0;
-      for (i=0; i<nc; i++) phaseProperties[columnLength+11+i] = oxVal[i]; 
-#ifndef TESTDYNAMICLIB
-      phaseProperties[columnLength+11+nc  ] = vLiq*10.0;
-      phaseProperties[columnLength+11+nc+1] = (vLiq != 0.0) ? 100.0*gramTot/vLiq : 0.0;
-      phaseProperties[columnLength+11+nc+2] = viscosityFromGRD(silminState->T, oxVal);
-#else
-      phaseProperties[columnLength+11+nc  ] = (mTot != 0.0) ? gramTot/mTot : 0.0;
-      phaseProperties[columnLength+11+nc+1] = (vLiq != 0.0) ? 100.0*gramTot/vLiq : 0.0;
-      //phaseProperties[columnLength+11+nc+2] = gramTot;
-      phaseProperties[columnLength+11+nc+2] = viscosityFromShaw(silminState->T, oxVal);
-#endif
-    } /* end liquid block */
-
-    /* begin solid block */
-    for (j=0; j<npc; j++) {
-      int ns;
-      for (ns=0; ns<(silminState->nSolidCoexist)[j]; ns++) {
-        double G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2, gramTot=0.0, mTot = 0.0;
-     
-        if (solids[j].na == 1) {
-          G       = (silminState->solidComp)[j][ns]*(solids[j].cur).g;
-          H       = (silminState->solidComp)[j][ns]*(solids[j].cur).h;
-          S       = (silminState->solidComp)[j][ns]*(solids[j].cur).s;
-          V       = (silminState->solidComp)[j][ns]*(solids[j].cur).v;
-          Cp      = (silminState->solidComp)[j][ns]*(solids[j].cur).cp;
-          dCpdT   = (silminState->solidComp)[j][ns]*(solids[j].cur).dcpdt;
-          dVdT    = (silminState->solidComp)[j][ns]*(solids[j].cur).dvdt;
-          dVdP    = (silminState->solidComp)[j][ns]*(solids[j].cur).dvdp;
-          d2VdT2  = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdt2;
-          d2VdTdP = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdtdp;
-          d2VdP2  = (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdp2;
-
-          totalG       += (silminState->solidComp)[j][ns]*(solids[j].cur).g;
-          totalH       += (silminState->solidComp)[j][ns]*(solids[j].cur).h;
-          totalS       += (silminState->solidComp)[j][ns]*(solids[j].cur).s;
-          totalV       += (silminState->solidComp)[j][ns]*(solids[j].cur).v;
-          totalCp      += (silminState->solidComp)[j][ns]*(solids[j].cur).cp;
-          totaldCpdT   += (silminState->solidComp)[j][ns]*(solids[j].cur).dcpdt;
-          totaldVdT    += (silminState->solidComp)[j][ns]*(solids[j].cur).dvdt;
-          totaldVdP    += (silminState->solidComp)[j][ns]*(solids[j].cur).dvdp;
-          totald2VdT2  += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdt2;
-          totald2VdTdP += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdtdp;
-          totald2VdP2  += (silminState->solidComp)[j][ns]*(solids[j].cur).d2vdp2;
-      
-          for (i=0; i<nc; i++) {
-            oxVal[i] = (solids[j].solToOx)[i]*bulkSystem[i].mw*(silminState->solidComp)[j][ns];
-            gramTot += oxVal[i];
-          }
-          mTot = (silminState->solidComp)[j][ns];
-      
-        } else {
-          for (i=0; i<solids[j].na; i++) m[i] = (silminState->solidComp)[j+1+i][ns];
-
-          (*solids[j].convert)(SECOND, THIRD, silminState->T, silminState->P, NULL, m, r, NULL, NULL, NULL, NULL, NULL);
-          (*solids[j].gmix) (FIRST, silminState->T, silminState->P, r, &G, NULL, NULL, NULL);
-          (*solids[j].hmix) (FIRST, silminState->T, silminState->P, r, &H);
-          (*solids[j].smix) (FIRST, silminState->T, silminState->P, r, &S, NULL, NULL);
-          (*solids[j].vmix) (FIRST | FOURTH | FIFTH | SIXTH | SEVENTH | EIGHTH, 
-          silminState->T, silminState->P, r, &V, NULL, NULL, &dVdT, &dVdP, &d2VdT2, &d2VdTdP, &d2VdP2, NULL, NULL);
-          (*solids[j].cpmix)(FIRST | SECOND, silminState->T, silminState->P, r, &Cp, &dCpdT, NULL);
-
-          G       *= (silminState->solidComp)[j][ns];
-          H       *= (silminState->solidComp)[j][ns]; 
-          S       *= (silminState->solidComp)[j][ns];
-          V       *= (silminState->solidComp)[j][ns];
-          Cp      *= (silminState->solidComp)[j][ns];
-          dCpdT   *= (silminState->solidComp)[j][ns];
-          dVdT    *= (silminState->solidComp)[j][ns];
-          dVdP    *= (silminState->solidComp)[j][ns];
-          d2VdT2  *= (silminState->solidComp)[j][ns];
-          d2VdTdP *= (silminState->solidComp)[j][ns];
-          d2VdP2  *= (silminState->solidComp)[j][ns];
-      
-          for (i=0; i<solids[j].na; i++) {
-            G       += m[i]*(solids[j+1+i].cur).g;
-            H       += m[i]*(solids[j+1+i].cur).h;
-            S       += m[i]*(solids[j+1+i].cur).s;
-            V       += m[i]*(solids[j+1+i].cur).v;
-            Cp      += m[i]*(solids[j+1+i].cur).cp;
-            dCpdT   += m[i]*(solids[j+1+i].cur).dcpdt;
-            dVdT    += m[i]*(solids[j+1+i].cur).dvdt;
-            dVdP    += m[i]*(solids[j+1+i].cur).dvdp;
-            d2VdT2  += m[i]*(solids[j+1+i].cur).d2vdt2;
-            d2VdTdP += m[i]*(solids[j+1+i].cur).d2vdtdp;
-            d2VdP2  += m[i]*(solids[j+1+i].cur).d2vdp2;
-          }
-
-          totalG       += G;
-          totalH       += H;
-          totalS       += S;
-          totalV       += V;
-          totalCp      += Cp;
-          totaldCpdT   += dCpdT;
-          totaldVdT    += dVdT;
-          totaldVdP    += dVdT;
-          totald2VdT2  += dVdT;
-          totald2VdTdP += dVdT;
-          totald2VdP2  += dVdT;
-      
-          for (i=0; i<nc; i++) {
-            int k;
-            for (k=0, oxVal[i]=0.0; k<solids[j].na; k++) oxVal[i] += (solids[j+1+k].solToOx)[i]*m[k]*bulkSystem[i].mw;
-            gramTot += oxVal[i];
-          }
-          for (i=0; i<solids[j].na; i++) mTot += m[i];
-        }
-
-        phaseProperties[(*numberPhases)*columnLength+ 0] = G;
-        phaseProperties[(*numberPhases)*columnLength+ 1] = H;
-        phaseProperties[(*numberPhases)*columnLength+ 2] = S;
-        phaseProperties[(*numberPhases)*columnLength+ 3] = V*10.0;
-        phaseProperties[(*numberPhases)*columnLength+ 4] = Cp;
-        phaseProperties[(*numberPhases)*columnLength+ 5] = dCpdT;
-        phaseProperties[(*numberPhases)*columnLength+ 6] = dVdT*10.0;
-        phaseProperties[(*numberPhases)*columnLength+ 7] = dVdP*10.0;
-        phaseProperties[(*numberPhases)*columnLength+ 8] = d2VdT2*10.0;
-        phaseProperties[(*numberPhases)*columnLength+ 9] = d2VdTdP*10.0;
-        phaseProperties[(*numberPhases)*columnLength+10] = d2VdP2*10.0;
-        for (i=0; i<nc; i++) phaseProperties[(*numberPhases)*columnLength+11+i] = oxVal[i]; 
-#ifndef TESTDYNAMICLIB
-        phaseProperties[(*numberPhases)*columnLength+11+nc  ] = V*10.0;
-        phaseProperties[(*numberPhases)*columnLength+11+nc+1] = (V != 0.0) ? 100.0*gramTot/V : 0.0;
-        phaseProperties[(*numberPhases)*columnLength+11+nc+2] = 0.0;
-#else
-        phaseProperties[(*numberPhases)*columnLength+11+nc  ] = (mTot != 0.0) ? gramTot/mTot : 0.0;
-        phaseProperties[(*numberPhases)*columnLength+11+nc+1] = (V != 0.0) ? 100.0*gramTot/V : 0.0;
-        phaseProperties[(*numberPhases)*columnLength+11+nc+2] = gramTot;
-#endif
-    
-        strncpy(phaseNames+(*numberPhases)*sizeof(char)*nCh,solids[j].label, nCh);
-        phaseIndices[(*numberPhases)] = j*10 + ns + 10;
-        (*numberPhases)++;
-    
-      } /* end loop on ns */
-    }  /* end loop on j */
-    /* end solid block */
-
-    /* system poperties */
-    phaseProperties[ 0] = gLiq + totalG;
-    phaseProperties[ 1] = hLiq + totalH;
-    phaseProperties[ 2] = sLiq + totalS;
-    phaseProperties[ 3] = (vLiq + totalV)*10.0;
-    phaseProperties[ 4] = cpLiq + totalCp;
-    phaseProperties[ 5] = dcpdtLiq + totaldCpdT;
-    phaseProperties[ 6] = (dvdtLiq + totaldVdT)*10.0;
-    phaseProperties[ 7] = (dvdpLiq + totaldVdP)*10.0;
-    phaseProperties[ 8] = (d2vdt2Liq + totald2VdT2)*10.0;
-    phaseProperties[ 9] = (d2vdtdpLiq + totald2VdTdP)*10.0;
-    phaseProperties[10] = (d2vdp2Liq + totald2VdP2)*10.0;
-    for (i=0, totalGrams=0.0, totalMoles = 0.0; i<nc; i++) {
-      phaseProperties[11+i] = (silminState->bulkComp)[i]*bulkSystem[i].mw;
-      totalGrams += phaseProperties[11+i];
-      totalMoles += (silminState->bulkComp)[i];
-    }
-#ifndef TESTDYNAMICLIB
-    phaseProperties[11+nc  ] = 1.0;
-    phaseProperties[11+nc+1] = ((vLiq+totalV) != 0.0) ? 100.0*totalGrams/(vLiq+totalV) : 0.0;
-    phaseProperties[11+nc+2] = 0.0;
-#else
-    phaseProperties[11+nc  ] = (totalMoles != 0.0) ? totalGrams/totalMoles : 0.0;
-    phaseProperties[11+nc+1] = ((vLiq+totalV) != 0.0) ? 100.0*totalGrams/(vLiq+totalV) : 0.0;
-    //phaseProperties[11+nc+2] = totalGrams;
-    phaseProperties[11+nc+2] = silminState->fo2;
-#endif
+    double hTotal, sTotal, vTotal;
+    int i;
 
-#ifndef TESTDYNAMICLIB
-    if ((vLiq+totalV) != 0.0) for (i=1; i<=(*numberPhases); i++) phaseProperties[i*columnLength+11+nc] /= 10.0*(vLiq+totalV);
-#endif
+    loadPhaseProperties(phaseNames, nCh, numberPhases, phaseProperties, phaseIndices, &hTotal, &sTotal, &vTotal);
 
     if (output < 2) {
       silminState->fractionateFlu = fractionateFlu;
@@ -1139,18 +1587,18 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
       *enthalpy    = 0.0;
       break;
     case 1:
-      *enthalpy    = hLiq+totalH;
+      *enthalpy    = hTotal;
       break;
     case 2:
-      silminState->refEnthalpy = hLiq+totalH;
+      silminState->refEnthalpy = hTotal;
       *enthalpy    = silminState->refEnthalpy;
       break;
     case 3:
-      silminState->refEntropy = sLiq+totalS;
+      silminState->refEntropy = sTotal;
       *entropy     = silminState->refEntropy;
       break;
     case 4:
-      silminState->refVolume = vLiq+totalV;
+      silminState->refVolume = vTotal;
       *volume      = 10.0*silminState->refVolume;
       break;
     default:
@@ -1163,8 +1611,220 @@ void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComp
     for (i=0; i<nc; i++) {
       bulkComposition[i] = (silminState->bulkComp)[i]*bulkSystem[i].mw;
     }
-    
-  } /* end output block */
+    
+  } /* end output block */
+
+  /* A fractionating node does not return to the same state, so it is not memoized */
+  if (memoEnabled) {
+    memoMisses++;
+    if (!fractionateSol && !fractionateFlu && !fractionateLiq)
+      storeMemo(thisNode, *mode, output, nCh, pressureIn, temperatureIn, enthalpyIn, bulkIn, *status,
+                *numberPhases, *pressure, *temperature, *enthalpy, bulkComposition, phaseNames,
+                phaseProperties, phaseIndices);
+    else invalidateMemo(thisNode);
+  }
+}
+
+/* ================================================================================== */
+/* Limits the work done by each subsequent equilibration, whatever the node          */
+/* Input:                                                                             */
+/*   wallTime             - elapsed time in seconds                                   */
+/*   quadIterations       - quadratic minimization iterations                         */
+/*   speciationIterations - iterations in the liquid speciation routines              */
+/*   Zero means no limit, which is the default.  An equilibration that reaches a      */
+/*   limit returns status 106 with the best state found so far.                       */
+/* ================================================================================== */
+
+void meltssetbudget_(double *wallTime, int *quadIterations, int *speciationIterations) {
+  meltsBudget.wallTime             = *wallTime;
+  meltsBudget.quadIterations       = *quadIterations;
+  meltsBudget.speciationIterations = *speciationIterations;
+}
+
+/* ================================================================================== */
+/* Lets meltsProcess return stored results, without equilibrating, when a call       */
+/* repeats the last inputs for a node that does not fractionate                       */
+/* Input:                                                                             */
+/*   enable    - TRUE to memoize, FALSE (the default) to equilibrate on every call   */
+/*   tolerance - relative difference allowed between inputs; zero for an exact match */
+/*   Inputs compared are mode, P, T, the H, S or V target, bulk composition and the   */
+/*   fO2 path.  Changing a system property of a node discards its stored results.     */
+/* ================================================================================== */
+
+void meltssetmemoization_(int *enable, double *tolerance) {
+  memoEnabled   = *enable;
+  memoTolerance = *tolerance;
+  if (memoEnabled) memoHits = memoMisses = 0;
+}
+
+/* ================================================================================== */
+/* Returns the number of memoized calls to meltsProcess answered from stored results  */
+/* (hits) and by equilibrating (misses) since memoization was last enabled            */
+/* ================================================================================== */
+
+void meltsgetmemostatistics_(int *hits, int *misses) {
+  *hits   = memoHits;
+  *misses = memoMisses;
+}
+
+/* ================================================================================== */
+/* Lets a search for the liquidus (mode 0 of meltsProcess) start from a temperature   */
+/* predicted from the liquidus temperatures already found for nearby compositions    */
+/* Input:                                                                             */
+/*   enable - TRUE to use the predictions, FALSE (the default) to start each search   */
+/*            from the temperature supplied                                          */
+/* ================================================================================== */
+
+void meltssetliquidussurrogate_(int *enable) {
+  meltsLiquidusSurrogate = *enable;
+}
+
+/* ================================================================================== */
+/* Discards the state of a node, and any stored results, once it is no longer needed */
+/* Input:                                                                             */
+/*   nodeIndex - node to release; unknown nodes are ignored                          */
+/*   A later call for the same node starts again from a new state.                   */
+/* ================================================================================== */
+
+void meltsreleasenode_(int *nodeIndex) {
+  NodeList *res = findNode(*nodeIndex);
+  if (res != NULL) removeNode(res);
+}
+
+/* ================================================================================== */
+/* Limits the number of nodes whose state is kept between calls                      */
+/* Input:                                                                             */
+/*   limit - maximum number of nodes; zero (the default) for no limit                */
+/*   Beyond the limit the node used least recently is released, exactly as by        */
+/*   meltsReleaseNode, so that its next call starts again from a new state.          */
+/* ================================================================================== */
+
+void meltssetnodelimit_(int *limit) {
+  maxNodes = (*limit > 0) ? *limit : 0;
+  if (maxNodes > 0) while (numberNodes > maxNodes) removeNode(oldestNode);
+}
+
+/* ================================================================================== */
+/* Holds the state of idle nodes in a compact form, with only the phases present,    */
+/* expanding it again when the node is next used                                     */
+/* Input:                                                                             */
+/*   enable - TRUE to compact idle nodes, FALSE (the default) to keep them expanded  */
+/*   Nodes that assimilate are always kept expanded.                                 */
+/* ================================================================================== */
+
+void meltssetcompactnodes_(int *enable) {
+  NodeList *entry;
+
+  compactNodes = *enable;
+  if (compactNodes) for (entry=oldestNode; entry!=NULL; entry=entry->newer)
+    if (entry != activeNode) compactNode(entry);
+}
+
+/* ================================================================================== */
+/* Returns the memory held by the state of nodes, excluding allocator overhead       */
+/* Output:                                                                            */
+/*   nodes        - number of nodes                                                   */
+/*   compactNodes - number of those held compact                                     */
+/*   bytes        - bytes held by the states of all nodes                            */
+/* ================================================================================== */
+
+void meltsgetnodememory_(int *nodes, int *compact, double *bytes) {
+  NodeList *entry;
+  int mode = calculationMode;
+
+  *nodes   = numberNodes;
+  *compact = 0;
+  *bytes   = 0.0;
+  for (entry=oldestNode; entry!=NULL; entry=entry->newer) {
+    if (entry->silminState == NULL) {
+      (*compact)++;
+      *bytes += (double) entry->compact->size;
+    } else {
+      if (entry->mode != calculationMode) selectModel(entry->mode);
+      *bytes += (double) stateBytes(entry->silminState);
+    }
+  }
+  if (mode != calculationMode) selectModel(mode);
+}
+
+/* ================================================================================== */
+/* Returns first order sensitivities of the last equilibrium state of a node          */
+/* Input:                                                                             */
+/*   nodeIndex       - node, which must have converged in its last meltsProcess call  */
+/*                     with mode = 1, its state unchanged since by other calls        */
+/*   nCharInName     - number of characters dimensioned for each name                 */
+/* Output:                                                                            */
+/*   phaseNames      - array of phase names, as for meltsProcess but without "system" */
+/*   numberPhases    - number of entries in phaseNames                                */
+/*   sensitivities   - 3-d array, for each phase nc+2 rows of nc values, the          */
+/*                     derivatives of the grams of each oxide in the phase with       */
+/*                     respect to T (K), P (bars), then the grams of each oxide in    */
+/*                     the bulk composition, i.e. in FORTRAN S(nc, nc+2, nPhases)     */
+/*   phaseIndices    - array of unique indices for phases, as for meltsProcess        */
+/*   status          - 0 = success, 105 = rank deficiency, 107 = not available for    */
+/*                     this node or its state (isenthalpic, isentropic, isochoric,    */
+/*                     fO2 buffered without liquid)                                   */
+/*   Derivatives are from the projected Hessian of the solver at the converged state  */
+/*   and hold while the assemblage is unchanged.  Oxides absent from the system have  */
+/*   zero derivatives.                                                                */
+/* ================================================================================== */
+
+void meltsgetsensitivities_(int *nodeIndex, char phaseNames[], int *nCharInName, int *numberPhases,
+                            double *sensitivities, int phaseIndices[], int *status) {
+  NodeList *thisNode = findNode(*nodeIndex);
+  int nCh = *nCharInName, nParams = nc + 2, nPhases, hasLiquid, rankDeficient;
+  double ***dPhaseOx, **dRows, *dValues;
+  int i, j, k, l, ns;
+
+  *numberPhases = 0;
+  *status = 107;
+  if (thisNode == NULL || !thisNode->converged) return;
+  activateNode(thisNode);
+  thermoDataT = 0.0; /* end-member properties are reevaluated at this node's T and P */
+  thermoDataP = 0.0;
+
+  hasLiquid = (silminState->liquidMass != 0.0);
+  for (i=0, nPhases=(hasLiquid ? silminState->nLiquidCoexist : 0); i<npc; i++) nPhases += (silminState->nSolidCoexist)[i];
+  dPhaseOx = (double ***) malloc((size_t) nPhases*sizeof(double **));
+  dRows    = (double **)  malloc((size_t) nPhases*nParams*sizeof(double *));
+  dValues  = (double *)   malloc((size_t) nPhases*nParams*nc*sizeof(double));
+  for (k=0; k<nPhases; k++) {
+    dPhaseOx[k] = dRows + k*nParams;
+    for (j=0; j<nParams; j++) dPhaseOx[k][j] = dValues + (k*nParams + j)*nc;
+  }
+
+  if (getEquilibriumSensitivities(dPhaseOx, &rankDeficient)) {
+    *status = 0;
+    if (hasLiquid) {
+      strncpy(phaseNames, "liquid", nCh);
+#ifndef TESTDYNAMICLIB
+      phaseIndices[0] = 2;
+#else
+      phaseIndices[0] = 0;
+#endif
+      for (j=0; j<nParams; j++) for (i=0; i<nc; i++) {
+        double d;
+        for (k=0, d=0.0; k<silminState->nLiquidCoexist; k++) d += dPhaseOx[k][j][i];
+        sensitivities[j*nc+i] = d;
+      }
+      *numberPhases = 1;
+    }
+    for (l=0, k=(hasLiquid ? silminState->nLiquidCoexist : 0); l<npc; l++) for (ns=0; ns<(silminState->nSolidCoexist)[l]; ns++, k++) {
+      for (j=0; j<nParams; j++) for (i=0; i<nc; i++) sensitivities[((*numberPhases)*nParams + j)*nc + i] = dPhaseOx[k][j][i];
+      strncpy(phaseNames + (*numberPhases)*sizeof(char)*nCh, solids[l].label, nCh);
+      phaseIndices[*numberPhases] = l*10 + ns + 10;
+      (*numberPhases)++;
+    }
+    /* moles of oxide per moles of oxide to grams per gram */
+    for (k=0; k<(*numberPhases); k++) for (j=0; j<nParams; j++) for (i=0; i<nc; i++) {
+      sensitivities[(k*nParams + j)*nc + i] *= bulkSystem[i].mw;
+      if (j >= 2) sensitivities[(k*nParams + j)*nc + i] /= bulkSystem[j-2].mw;
+    }
+  } else if (rankDeficient) *status = 105;
+
+  free(dValues);
+  free(dRows);
+  free(dPhaseOx);
 }
 
 /* ================================================================================== */
@@ -1205,11 +1865,17 @@ void meltsgeterrorstring_(int *status, char *errorString, int *nCharInName) {
       strncpy(errorString, "Rank deficiency coondition detected.  Most likely a consequence of phase rule violation.", nCh);
       break;
     case 106:
-      strncpy(errorString, "Time limit exceeded.", nCh);
+      strncpy(errorString, "Time or iteration limit exceeded.", nCh);
       break;
     case 107:
       strncpy(errorString, "Unspecified internal fatal error.", nCh);
       break;
+    case 108:
+      strncpy(errorString, "Unknown phase or oxide identifier.", nCh);
+      break;
+    case 109:
+      strncpy(errorString, "More phases than room was provided for.", nCh);
+      break;
     case 500:
       strncpy(errorString, "Successfully found liquidus.  No errors detected.", nCh);
       break;
@@ -1291,32 +1957,15 @@ void driveMeltsProcess(int *failure, int *mode, double *pressure, double *bulkCo
 /* ================================================================================== */
 
 void meltssetsystemproperty_(int *nodeIndex, char *property) {
-  int i, len;
+  NodeList *thisNode;
+  int i, len, created;
   char line[REC];
 
   if (!iAmInitialized) initializeLibrary();
 
-  if (numberNodes != 0) {
-    NodeList key, *res;
-    key.node = *nodeIndex;
-    res = bsearch(&key, nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    if (res == NULL) {
-      numberNodes++;
-      nodeList = (NodeList *) realloc(nodeList, (size_t) numberNodes*sizeof(struct _nodeList));
-      (nodeList[numberNodes-1]).silminState = createSilminState();
-      (nodeList[numberNodes-1]).node = *nodeIndex;
-      silminState = (nodeList[numberNodes-1]).silminState;
-      qsort(nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    } else { 
-      silminState = res->silminState;
-    } 
-  }  else {
-    numberNodes = 1;
-    nodeList = (NodeList *) realloc(nodeList, sizeof(struct _nodeList));
-    (nodeList[0]).silminState = createSilminState();
-    (nodeList[0]).node = *nodeIndex;
-    silminState = (nodeList[0]).silminState;
-  }
+  thisNode = registerNode(*nodeIndex, &created);
+  activateNode(thisNode);
+  if (!created) invalidateNode(thisNode);
 
   len = strlen(property); for (i=0; i<MIN(len, REC); i++) line[i] = tolower(property[i]);
 
@@ -1420,43 +2069,36 @@ void setMeltsSystemProperties(int *failure, char *strings, int *nCharInString, i
 #endif
 }
 
-/* ================================================================================== */
-/* Retrieves properties of solid and liquid phases                                    */
-/* Input:                                                                             */
-/*   phaseName       - string as returned from meltsGetPhaseNames                     */
-/*   temperature     - Temperature in Kelvins of the node                             */
-/*   pressure        - Pressure in bars of the node                                   */
-/*   bulkComposition - Bulk composition of the phase in grams of oxides               */ 
-/* Output:                                                                            */
-/*   phaseProperties - 1-d array, properties in the order                             */
-/*                     G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2     */
-/* ================================================================================== */
+/* Work space for the property calls below.  It is allocated once, with the         */
+/* dimensions of the largest model (see initializeLibrary()).                         */
 
-void meltsgetphaseproperties_(char *phaseName, double *temperature, 
-         double *pressure, double *bulkComposition, double *phaseProperties) {
-  PhaseList *res;
+static double *scratchM, *scratchR, *scratchMu;
 
-  if (!iAmInitialized) initializeLibrary();
-  
-  if (phaseList == NULL) {
-    initializePhaseList();
-  }
+static void allocatePropertyScratch(void) {
+  int n = MAX(MAX(nlc, workNa), nc);
+  if (scratchM != NULL) return;
+  scratchM  = (double *) malloc((size_t) n*sizeof(double));
+  scratchR  = (double *) malloc((size_t) MAX(nlc-1, workNr)*sizeof(double));
+  scratchMu = (double *) malloc((size_t) n*sizeof(double));
+}
 
-  strcpy(key.name, phaseName);
-  res = bsearch(&key, phaseList, (size_t) np, sizeof(struct _phaseList), comparePhases);
-  
-  if (res == NULL) { phaseProperties = NULL; return; }
-  else { 
-    int i, j = res->index;
+/* Properties of phase j (solids[] index, < 0 for liquid), as described below */
+
+static void getPhaseProperties(int j, double *temperature, double *pressure, double *bulkComposition, 
+                               double *phaseProperties) {
+  thermoDataT = 0.0; /* end-member properties are reevaluated below */
+  thermoDataP = 0.0;
+  allocatePropertyScratch();
+
+  { 
+    int i;
     double G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2, totalGrams, totalMoles;
     
     if (j < 0) { /* liquid */
-      double *m, *r, mTot, *mu;
+      double *m = scratchM, *r = scratchR, mTot, *mu = scratchMu;
       int k;
-      m = (double *) calloc((size_t) nlc,    sizeof(double));
-      r = (double *) malloc((size_t) (nlc-1)*sizeof(double));
+      for (i=0; i<nlc; i++) m[i] = mu[i] = 0.0;
       for (k=0; k<nc; k++) for (i=0; i<nlc; i++) m[i] += (bulkSystem[k].oxToLiq)[i]*bulkComposition[k]/bulkSystem[k].mw;
-      mu = (double *) calloc((size_t) nlc, sizeof(double));
 
       if ((silminState != NULL) && (silminState->fo2Path != FO2_NONE)) {
         silminState->fo2 = getlog10fo2(*temperature, *pressure, silminState->fo2Path);
@@ -1514,14 +2156,10 @@ void meltsgetphaseproperties_(char *phaseName, double *temperature,
       totalMoles = mTot;
 #endif
 
-      free(m);
-      free(r);
-      free(mu);
-
     } else if (solids[j].na == 1) {
       double mass = 0.0, factor = 1.0;
       for (i=0; i<nc; i++) mass += bulkComposition[i];
-      gibbs(*temperature, *pressure, phaseName, &solids[j].ref, NULL, NULL, &solids[j].cur);
+      gibbs(*temperature, *pressure, (char *) solids[j].label, &solids[j].ref, NULL, NULL, &solids[j].cur);
       factor = mass/solids[j].mw;
       
       G       = factor*(solids[j].cur).g;
@@ -1544,15 +2182,13 @@ void meltsgetphaseproperties_(char *phaseName, double *temperature,
 #endif
 
     } else {
-      double e[106], *m, *r, mTot, *mu; 
+      double e[106], *m = scratchM, *r = scratchR, mTot, *mu = scratchMu; 
       int k;
       for (i=0; i<106; i++) e[i] = 0.0;
       for (i=0; i<nc; i++) {
         double mOx = bulkComposition[i]/bulkSystem[i].mw;
         for (k=0; k<106; k++) e[k] += mOx*(bulkSystem[i].oxToElm)[k];
       }
-      m = (double *) malloc ((size_t) solids[j].na*sizeof(double));
-      r = (double *) malloc ((size_t) solids[j].nr*sizeof(double));
 
       if (!strncmp(solids[j].label,"clinopyroxene", MIN((int) strlen(solids[j].label), 13)) || 
         !strncmp(solids[j].label,"orthopyroxene", MIN((int) strlen(solids[j].label), 13))) {
@@ -1592,7 +2228,6 @@ void meltsgetphaseproperties_(char *phaseName, double *temperature,
       }
 
       (*solids[j].convert)(SECOND, THIRD, *temperature, *pressure, NULL, m, r, NULL, NULL, NULL, NULL, NULL);
-      mu = (double *) malloc ((size_t) solids[j].na*sizeof(double));
 
       for (i=0, mTot=0.0; i<solids[j].na; i++) {
         mTot += m[i];
@@ -1644,10 +2279,6 @@ void meltsgetphaseproperties_(char *phaseName, double *temperature,
       totalMoles = mTot;
 #endif
 
-      free(m);
-      free(r);
-      free(mu);
-
     }
 
     phaseProperties[ 0] = G;
@@ -1674,6 +2305,35 @@ void meltsgetphaseproperties_(char *phaseName, double *temperature,
   }
 }
 
+/* ================================================================================== */
+/* Retrieves properties of solid and liquid phases                                    */
+/* Input:                                                                             */
+/*   phaseName       - string as returned from meltsGetPhaseNames                     */
+/*   temperature     - Temperature in Kelvins of the node                             */
+/*   pressure        - Pressure in bars of the node                                   */
+/*   bulkComposition - Bulk composition of the phase in grams of oxides               */ 
+/* Output:                                                                            */
+/*   phaseProperties - 1-d array, properties in the order                             */
+/*                     G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2     */
+/* ================================================================================== */
+
+void meltsgetphaseproperties_(char *phaseName, double *temperature, 
+         double *pressure, double *bulkComposition, double *phaseProperties) {
+  PhaseList *res;
+
+  if (!iAmInitialized) initializeLibrary();
+  
+  if (phaseList == NULL) {
+    initializePhaseList();
+  }
+
+  strcpy(key.name, phaseName);
+  res = bsearch(&key, phaseList, (size_t) np, sizeof(struct _phaseList), comparePhases);
+  
+  if (res == NULL) { phaseProperties = NULL; return; }
+  getPhaseProperties(res->index, temperature, pressure, bulkComposition, phaseProperties);
+}
+
 /* ================================================================================== */
 /* Input and Output (as above)                                                        */
 /* ================================================================================== */
@@ -1698,6 +2358,85 @@ void getMeltsPhaseProperties(int *failure, char *phaseName, double *temperature,
   }
 #endif  
 }
+
+/* ================================================================================== */
+/* Retrieves properties of all phases present in a node after a call to meltsprocess_ */
+/* End-member properties evaluated by the last call to silmin() are reused if that    */
+/* call was for the same temperature and pressure; otherwise they are evaluated once  */
+/* for the liquid and the phases present, not once per phase.                         */
+/* Input:                                                                             */
+/*   nodeIndex       - Index number of node, as passed to meltsprocess_               */
+/*   nCharInName     - number of characters dimensioned for each name                 */
+/* Output:                                                                            */
+/*   phaseNames      - as returned from meltsprocess_                                 */
+/*   numberPhases    - number of entries in phaseNames and columns in phaseProperties */
+/*                     zero if the node does not exist                                */
+/*   phaseProperties - 2-d array, one column per phase, same layout as that returned  */
+/*                     from meltsprocess_                                             */
+/*   phaseIndices    - as returned from meltsprocess_                                 */
+/* ================================================================================== */
+
+void meltsgetallphaseproperties_(int *nodeIndex, char phaseNames[], int *nCharInName, int *numberPhases,
+         double *phaseProperties, int phaseIndices[]) {
+  NodeList *res;
+  double hTotal, sTotal, vTotal;
+  int i, k;
+
+  if (!iAmInitialized) initializeLibrary();
+
+  *numberPhases = 0;
+  if ((res = findNode(*nodeIndex)) == NULL) return;
+  activateNode(res);
+
+  if ((silminState->T != thermoDataT) || (silminState->P != thermoDataP)) {
+    for (i=0; i<nlc; i++) gibbs(silminState->T, silminState->P, (char *) liquid[i].label, &(liquid[i].ref),
+                            &(liquid[i].liq), &(liquid[i].fus), &(liquid[i].cur));
+    for (i=0; i<npc; i++) if ((solids[i].type == PHASE) && ((silminState->nSolidCoexist)[i] > 0)) {
+      if (solids[i].na == 1) gibbs(silminState->T, silminState->P, (char *) solids[i].label, &(solids[i].ref), NULL, NULL, &(solids[i].cur));
+      else for (k=0; k<solids[i].na; k++) 
+        gibbs(silminState->T, silminState->P, (char *) solids[i+1+k].label, &(solids[i+1+k].ref), NULL, NULL, &(solids[i+1+k].cur));
+    }
+    /* only the phases present were updated */
+    thermoDataT = 0.0;
+    thermoDataP = 0.0;
+  }
+
+  loadPhaseProperties(phaseNames, *nCharInName, numberPhases, phaseProperties, phaseIndices, &hTotal, &sTotal, &vTotal);
+}
+
+/* ================================================================================== */
+/* Input and Output (as above except):                                                */
+/*   phasePtr     - array of blank strings, assumed all to be of the same length      */
+/*   numberPhases - input lt or equal to amount of allocated storage, output as above */
+/* ================================================================================== */
+
+void getMeltsAllPhaseProperties(int *failure, int *nodeIndex, char *phasePtr, int *nCharInName, int *numberPhases,
+         double *phaseProperties, int phaseIndices[]) {
+  int i, nCh = *nCharInName, np = *numberPhases;
+  char *phaseNames = (char *) malloc((size_t) nCh*np*sizeof(char));
+
+#ifdef USESJLJ
+  if (setjmp(env) == 0) {
+    setErrorHandler();
+#elif defined(USESEH)
+    doInterrupt = FALSE;
+#endif
+    for (i=0; i<nCh*np; i++) phasePtr[i] = '\0';
+    meltsgetallphaseproperties_(nodeIndex, phaseNames, nCharInName, numberPhases, phaseProperties, phaseIndices);
+    np = *numberPhases;
+    for (i=0; i<nCh*np; i++) {
+      if (phaseNames[i] == '\0') phasePtr[i] = ' ';
+      else phasePtr[i] = phaseNames[i];
+    }
+    free(phaseNames);
+    *failure = (np == 0);
+#ifdef USESEH
+    *failure = (*failure) ? (*failure) : doInterrupt;
+#elif defined(USESJLJ)
+  }
+#endif
+}
+
 /* ================================================================================== */
 /* Retrieves properties of solid and liquid phases using mole fractions of endmembers */
 /* Input:                                                                             */
@@ -1715,6 +2454,8 @@ void meltsgetmolarproperties_(char *phaseName, double *temperature,
   PhaseList *res;
 
   if (!iAmInitialized) initializeLibrary();
+  thermoDataT = 0.0; /* end-member properties are reevaluated below */
+  thermoDataP = 0.0;
   
   if (phaseList == NULL) {
     initializePhaseList();
@@ -1932,6 +2673,8 @@ void meltsgetendmemberproperties_(char *phaseName, double *temperature,
   int nCh = *nCharInName;
 
   if (!iAmInitialized) initializeLibrary();
+  thermoDataT = 0.0; /* end-member properties are reevaluated below */
+  thermoDataP = 0.0;
 
   if (phaseList == NULL) {
     initializePhaseList();
@@ -2166,6 +2909,61 @@ void getMeltsEndMemberProperties(int *failure, char *phaseName, double *temperat
 /*   oxideProperties - 1-d array, properties in the order X, mu0, mu                  */
 /* ================================================================================== */
 
+/* Oxide properties of a liquid, in the layout described below */
+
+static void getLiquidOxideProperties(double *temperature, double *pressure, double *bulkComposition, 
+                                     double *oxideProperties) {
+  int i, k;
+  int columnLength = 4; /* X, act, mu0, mu */
+  double *m, *r, *muLiq, mTot, totalMoles;
+
+  thermoDataT = 0.0; /* end-member properties are reevaluated below */
+  thermoDataP = 0.0;
+  allocatePropertyScratch();
+  m = scratchM; r = scratchR; muLiq = scratchMu;
+
+  for (i=0; i<nlc; i++) m[i] = 0.0;
+  for (k=0; k<nc; k++) for (i=0; i<nlc; i++) m[i] += (bulkSystem[k].oxToLiq)[i]*bulkComposition[k]/bulkSystem[k].mw;
+
+  if ((silminState != NULL) && (silminState->fo2Path != FO2_NONE)) {
+    silminState->fo2 = getlog10fo2(*temperature, *pressure, silminState->fo2Path);
+    conLiq(FIRST | SEVENTH, FIRST, *temperature, *pressure, m, NULL, NULL, NULL, NULL, NULL, &(silminState->fo2));
+  }
+
+  conLiq(SECOND, THIRD, *temperature, *pressure, NULL, m, r, NULL, NULL, NULL, NULL);
+  actLiq(SECOND, *temperature, *pressure, r, NULL, muLiq, NULL, NULL);
+
+  for (i=0, totalMoles = 0.0; i<nlc; i++) {
+    totalMoles += m[i];
+    gibbs(*temperature, *pressure, (char *) liquid[i].label, &(liquid[i].ref), &(liquid[i].liq), &(liquid[i].fus), &(liquid[i].cur));
+    muLiq[i] += (liquid[i].cur).g;
+  }   
+
+  for (k=0; k<columnLength*nc; k++) oxideProperties[k] = 0.0;
+  for (i=0; i<nlc; i++) for (k=0; k<nc; k++) if (m[i] != 0.0)
+    oxideProperties[k*columnLength+ 0] += (liquid[i].liqToOx)[k] * m[i];
+  for (k=0; k<nc; k++) for (i=0; i<nlc; i++) if (m[i] != 0.0)
+    oxideProperties[k*columnLength+ 3] += (bulkSystem[k].oxToLiq)[i] * muLiq[i];
+  for (k=0, mTot=0.0; k<nc; k++) mTot += oxideProperties[k*columnLength +0];
+
+  for (k=0; k<nc; k++) {
+    if (oxideProperties[k*columnLength +0] != 0.0) {
+      int len = strlen(bulkSystem[k].label);
+      for (i=0; i<nlc; i++) {
+        if (!strncmp(bulkSystem[k].label, liquid[i].label, MIN(len, strlen(liquid[i].label)))) {
+          muLiq[k] = oxideProperties[k*columnLength +3] - (liquid[i].cur).g;
+          oxideProperties[k*columnLength+ 1] = exp(muLiq[k]/(*temperature*R));
+          oxideProperties[k*columnLength+ 2] = (liquid[i].cur).g;
+          break;
+        }
+      }
+      if (mTot != 0.0) oxideProperties[k*columnLength +0] /= mTot;
+      oxideProperties[k*columnLength +3] *= mTot/totalMoles;
+    }
+    else oxideProperties[k*columnLength +3] = 0.0;
+  }
+}
+
 void meltsgetoxideproperties_(char *phaseName, double *temperature, 
          double *pressure, double *bulkComposition, char oxideNames[], 
 	 int *nCharInName, int *numberOxides, double *oxideProperties) {
@@ -2183,65 +2981,12 @@ void meltsgetoxideproperties_(char *phaseName, double *temperature,
   
   if (res == NULL) { oxideProperties = NULL; return; }
   else { 
-    int i, j = res->index;
-    int columnLength = 4; /* X, act, mu0, mu */
-    double totalMoles;
+    int k, j = res->index;
     
     if (j < 0) { /* liquid */
-      double *m, *r, mTot;
-      double *muLiq;
-      int k;
-
-      m = (double *) calloc((size_t) nlc,    sizeof(double));
-      r = (double *) malloc((size_t) (nlc-1)*sizeof(double));
-      muLiq = (double *) malloc((size_t) nlc*sizeof(double));
-      for (k=0; k<nc; k++) for (i=0; i<nlc; i++) m[i] += (bulkSystem[k].oxToLiq)[i]*bulkComposition[k]/bulkSystem[k].mw;
-
-      if ((silminState != NULL) && (silminState->fo2Path != FO2_NONE)) {
-        silminState->fo2 = getlog10fo2(*temperature, *pressure, silminState->fo2Path);
-        conLiq(FIRST | SEVENTH, FIRST, *temperature, *pressure, m, NULL, NULL, NULL, NULL, NULL, &(silminState->fo2));
-      }
-
-      conLiq(SECOND, THIRD, *temperature, *pressure, NULL, m, r, NULL, NULL, NULL, NULL);
-      actLiq(SECOND, *temperature, *pressure, r, NULL, muLiq, NULL, NULL);
-
-      for (i=0, totalMoles = 0.0; i<nlc; i++) {
-        totalMoles += m[i];
-        gibbs(*temperature, *pressure, (char *) liquid[i].label, &(liquid[i].ref), &(liquid[i].liq), &(liquid[i].fus), &(liquid[i].cur));
-        muLiq[i] += (liquid[i].cur).g;
-      }   
-
-      for (k=0; k<columnLength*nc; k++) oxideProperties[k] = 0.0;
-      for (i=0; i<nlc; i++) for (k=0; k<nc; k++) if (m[i] != 0.0)
-        oxideProperties[k*columnLength+ 0] += (liquid[i].liqToOx)[k] * m[i];
-      for (k=0; k<nc; k++) for (i=0; i<nlc; i++) if (m[i] != 0.0)
-        oxideProperties[k*columnLength+ 3] += (bulkSystem[k].oxToLiq)[i] * muLiq[i];
-      for (k=0, mTot=0.0; k<nc; k++) mTot += oxideProperties[k*columnLength +0];
-
-      for (k=0; k<nc; k++) {
-        if (oxideProperties[k*columnLength +0] != 0.0) {
-          int len = strlen(bulkSystem[k].label);
-          for (i=0; i<nlc; i++) {
-            if (!strncmp(bulkSystem[k].label, liquid[i].label, MIN(len, strlen(liquid[i].label)))) {
-              muLiq[k] = oxideProperties[k*columnLength +3] - (liquid[i].cur).g;
-              oxideProperties[k*columnLength+ 1] = exp(muLiq[k]/(*temperature*R));
-              oxideProperties[k*columnLength+ 2] = (liquid[i].cur).g;
-              break;
-            }
-          }
-          if (mTot != 0.0) oxideProperties[k*columnLength +0] /= mTot;
-          oxideProperties[k*columnLength +3] *= mTot/totalMoles;
-        }
-        else oxideProperties[k*columnLength +3] = 0.0;
-      }
-
+      getLiquidOxideProperties(temperature, pressure, bulkComposition, oxideProperties);
       for (k=0; k<nc; k++) strncpy(oxideNames+k*sizeof(char)*nCh,bulkSystem[k].label, nCh);
       (*numberOxides) = nc;
-      
-      free(m);
-      free(r);
-      free(muLiq);
-
     }
     /* else if (solids[j].na == 1) {*/ /* never used */
     /* else { */
@@ -2293,45 +3038,231 @@ void getMeltsOxideProperties(int *failure, char *phaseName, double *temperature,
 #endif  
 }
 
+/* ================================================================================== */
+/* Identifier based interface, version 1                                              */
+/* Phases and oxides are referred to by integer identifiers, looked up once from      */
+/* their names, and results are written into arrays owned by the caller with          */
+/* arbitrary strides, so a code coupling MELTS to a transport solver can exchange     */
+/* data with its own field arrays without repacking.  Work space is allocated on the  */
+/* first call only.                                                                   */
+/*   phase identifiers - the phaseIndices of meltsGetPhaseNames and meltsProcess,     */
+/*                       i.e. 1 for the system, 2 for liquid and 10*(i+1) for the     */
+/*                       solid phase solids[i], plus n for its n-th coexisting        */
+/*                       instance when returned from meltsProcessV1                   */
+/*   oxide identifiers - position in the order of meltsGetOxideNames, from zero       */
+/* Strides are counted in doubles.  For a FORTRAN array P(nProperties, nPhases), the  */
+/* layout of meltsProcess, propertyStride = 1 and phaseStride = nProperties; for the  */
+/* transpose propertyStride = nPhases and phaseStride = 1.                            */
+/* ================================================================================== */
+
+#define MELTS_API_VERSION 1
+#ifndef TESTDYNAMICLIB
+#define SYSTEM_PHASE_ID  1
+#define LIQUID_PHASE_ID  2
+#else
+#define SYSTEM_PHASE_ID -10
+#define LIQUID_PHASE_ID  0
+#endif
+#define UNKNOWN_ID      -1
+
+/* solids[] index for a phase identifier, -1 for liquid and -2 if there is no such phase */
+
+static int phaseForId(int phaseId) {
+  int i;
+  if (phaseId == LIQUID_PHASE_ID) return -1;
+  if (phaseId < 10) return -2;
+  i = phaseId/10 - 1;
+  return ((i < npc) && (solids[i].type == PHASE)) ? i : -2;
+}
+
+/* ================================================================================== */
+/* Output:                                                                            */
+/*   version          - MELTS_API_VERSION, which a caller should check                */
+/*   numberOxides     - number of oxide identifiers                                   */
+/*   numberProperties - number of properties per phase returned by meltsProcessV1    */
+/* ================================================================================== */
+
+void meltsgetapiversion_(int *version, int *numberOxides, int *numberProperties) {
+  if (!iAmInitialized) initializeLibrary();
+  *version          = MELTS_API_VERSION;
+  *numberOxides     = nc;
+  *numberProperties = 11 + nc + 3;
+}
+
+/* ================================================================================== */
+/* Input:                                                                             */
+/*   phaseName - zero terminated string as returned from meltsGetPhaseNames           */
+/* Output:                                                                            */
+/*   phaseId   - phase identifier, -1 if there is no such phase                       */
+/* ================================================================================== */
+
+void meltsgetphaseid_(char *phaseName, int *phaseId) {
+  PhaseList *res;
+
+  if (!iAmInitialized) initializeLibrary();
+  if (phaseList == NULL) {
+    initializePhaseList();
+  }
+
+  *phaseId = UNKNOWN_ID;
+#ifndef TESTDYNAMICLIB
+  if (!strcmp(phaseName, "system")) { *phaseId = SYSTEM_PHASE_ID; return; }
+#else
+  if (!strcmp(phaseName, "bulk"))   { *phaseId = SYSTEM_PHASE_ID; return; }
+#endif
+  if ((int) strlen(phaseName) >= keyLength) return;
+
+  strcpy(key.name, phaseName);
+  res = bsearch(&key, phaseList, (size_t) np, sizeof(struct _phaseList), comparePhases);
+  if (res != NULL) *phaseId = (res->index < 0) ? LIQUID_PHASE_ID : 10*res->index + 10;
+}
+
+/* ================================================================================== */
+/* Input:                                                                             */
+/*   oxideName - zero terminated string as returned from meltsGetOxideNames           */
+/* Output:                                                                            */
+/*   oxideId   - oxide identifier, -1 if there is no such oxide                       */
+/* ================================================================================== */
+
+void meltsgetoxideid_(char *oxideName, int *oxideId) {
+  int i;
+  if (!iAmInitialized) initializeLibrary();
+  for (i=0, *oxideId=UNKNOWN_ID; i<nc; i++) if (!strcmp(oxideName, bulkSystem[i].label)) { *oxideId = i; break; }
+}
+
+/* ================================================================================== */
+/* As meltsProcess, except:                                                           */
+/* Input:                                                                             */
+/*   bulkStride      - stride of bulkComposition, which is also output as before      */
+/*   maxPhases       - number of phases for which phaseIds and phaseProperties have   */
+/*                     room                                                           */
+/*   propertyStride  - stride between the properties of a phase in phaseProperties    */
+/*   phaseStride     - stride between phases in phaseProperties                       */
+/* Output:                                                                            */
+/*   numberPhases    - number of phases, including the system, which may exceed       */
+/*                     maxPhases; only the first maxPhases are returned               */
+/*   phaseIds        - phase identifiers in place of phaseNames and phaseIndices      */
+/*   phaseProperties - numberProperties values per phase as for meltsProcess          */
+/*   status          - as for meltsProcess, or 109 if a non-fatal return has more     */
+/*                     phases than maxPhases                                          */
+/* ================================================================================== */
+
+void meltsprocessv1_(int *nodeIndex, int *mode, double *pressure, double *bulkComposition, int *bulkStride,
+                     double *enthalpy, double *temperature, int *maxPhases, int *numberPhases, int phaseIds[],
+                     double *phaseProperties, int *propertyStride, int *phaseStride, int *status) {
+  static double *bulk, *properties;
+  static char *names;
+  static int *indices;
+  int i, k, nPhases, nCh = 1, iterations = 0, columnLength = 11 + nc + 3;
+
+  if (!iAmInitialized) initializeLibrary();
+  if (bulk == NULL) {
+    /* there is a column for every phase the phase rule allows, and then some */
+    int maxColumns = 2 + nc + workNpc;
+    bulk       = (double *) malloc((size_t) nc*sizeof(double));
+    properties = (double *) malloc((size_t) maxColumns*columnLength*sizeof(double));
+    names      = (char *)   malloc((size_t) maxColumns*nCh*sizeof(char));
+    indices    = (int *)    malloc((size_t) maxColumns*sizeof(int));
+  }
+
+  for (i=0; i<nc; i++) bulk[i] = bulkComposition[i*(*bulkStride)];
+  meltsprocess_(nodeIndex, mode, pressure, bulk, enthalpy, temperature, names, &nCh, numberPhases,
+                &iterations, status, properties, indices);
+  for (i=0; i<nc; i++) bulkComposition[i*(*bulkStride)] = bulk[i];
+
+  nPhases = MIN(*numberPhases, *maxPhases);
+  for (k=0; k<nPhases; k++) {
+    phaseIds[k] = indices[k];
+    for (i=0; i<columnLength; i++) phaseProperties[k*(*phaseStride) + i*(*propertyStride)] = properties[k*columnLength + i];
+  }
+  if ((*numberPhases > *maxPhases) && (*status < 100)) *status = 109;
+}
+
+/* ================================================================================== */
+/* As meltsGetPhaseProperties, except:                                                */
+/* Input:                                                                             */
+/*   phaseId         - phase identifier of liquid or a solid phase                    */
+/*   bulkStride      - stride of bulkComposition                                      */
+/*   propertyStride  - stride of phaseProperties                                      */
+/* Output:                                                                            */
+/*   phaseProperties - G, H, S, V, Cp, dCpdT, dVdT, dVdP, d2VdT2, d2VdTdP, d2VdP2     */
+/*   status          - 0 = success, 108 = unknown phase identifier                    */
+/* ================================================================================== */
+
+void meltsgetphasepropertiesv1_(int *phaseId, double *temperature, double *pressure, double *bulkComposition,
+                                int *bulkStride, double *phaseProperties, int *propertyStride, int *status) {
+  static double *bulk, *properties;
+  int i, j;
+
+  if (!iAmInitialized) initializeLibrary();
+  if (bulk == NULL) {
+    bulk       = (double *) malloc((size_t) nc*sizeof(double));
+    properties = (double *) malloc((size_t) (11 + MAX(MAX(nlc, workNa), nc+3))*sizeof(double));
+  }
+
+  if ((j = phaseForId(*phaseId)) == -2) { *status = 108; return; }
+  for (i=0; i<nc; i++) bulk[i] = bulkComposition[i*(*bulkStride)];
+  getPhaseProperties(j, temperature, pressure, bulk, properties);
+  for (i=0; i<11; i++) phaseProperties[i*(*propertyStride)] = properties[i];
+  *status = 0;
+}
+
+/* ================================================================================== */
+/* As meltsGetOxideProperties, except:                                                */
+/* Input:                                                                             */
+/*   phaseId         - phase identifier, which must be that of liquid                 */
+/*   bulkStride      - stride of bulkComposition                                      */
+/*   oxideStride     - stride between oxides in oxideProperties                       */
+/*   propertyStride  - stride between the properties of an oxide in oxideProperties   */
+/* Output:                                                                            */
+/*   oxideProperties - X, act, mu0, mu for each oxide, in order of oxide identifier   */
+/*   status          - 0 = success, 108 = unknown or unsupported phase identifier     */
+/* ================================================================================== */
+
+void meltsgetoxidepropertiesv1_(int *phaseId, double *temperature, double *pressure, double *bulkComposition,
+                                int *bulkStride, double *oxideProperties, int *oxideStride, int *propertyStride,
+                                int *status) {
+  static double *bulk, *properties;
+  int i, k;
+
+  if (!iAmInitialized) initializeLibrary();
+  if (bulk == NULL) {
+    bulk       = (double *) malloc((size_t) nc*sizeof(double));
+    properties = (double *) malloc((size_t) 4*nc*sizeof(double));
+  }
+
+  if (phaseForId(*phaseId) != -1) { *status = 108; return; }
+  for (i=0; i<nc; i++) bulk[i] = bulkComposition[i*(*bulkStride)];
+  getLiquidOxideProperties(temperature, pressure, bulk, properties);
+  for (k=0; k<nc; k++) for (i=0; i<4; i++) oxideProperties[k*(*oxideStride) + i*(*propertyStride)] = properties[k*4 + i];
+  *status = 0;
+}
+
 /* ================================================================================== */
 /* ================================================================================== */
 
 void meltssaturationstate_(int *nodeIndex, double *pressure, double *bulkComposition, double *temperature, 
         char phaseNames[], int *nCharInName, int *numberPhases, double *phaseProperties, int phaseIndices[]) {
-  int update = FALSE;
+  NodeList *thisNode;
+  int update = FALSE, created;
   int i, j, k, np=0, nCh = *nCharInName, columnLength = nlc+1;
   double *m = (double *) calloc((size_t) nlc,    sizeof(double));
   if (!iAmInitialized) initializeLibrary();
-
-  if (numberNodes != 0) {
-    NodeList key, *res;
-    key.node = *nodeIndex;
-    res = bsearch(&key, nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    if (res == NULL) {
-      numberNodes++;
-      nodeList = (NodeList *) realloc(nodeList, (size_t) numberNodes*sizeof(struct _nodeList));
-      (nodeList[numberNodes-1]).silminState = createSilminState();
-      (nodeList[numberNodes-1]).node = *nodeIndex;
-      silminState = (nodeList[numberNodes-1]).silminState;
-      qsort(nodeList, (size_t) numberNodes, sizeof(struct _nodeList), compareNodes);
-    } else { 
-      int i;
-      silminState = res->silminState;
-      for(i=0; i<nc; i++) {
-        if((silminState->bulkComp)[i] != 0.0) {
-          update = TRUE;
-          break;
-        }
+  thermoDataT = 0.0; /* end-member properties are reevaluated below */
+  thermoDataP = 0.0;
+
+  thisNode = registerNode(*nodeIndex, &created);
+  activateNode(thisNode);
+  if (!created) {
+    invalidateNode(thisNode);
+    for(i=0; i<nc; i++) {
+      if((silminState->bulkComp)[i] != 0.0) {
+        update = TRUE;
+        break;
       }
-    } 
-  } else {
-    numberNodes = 1;
-    nodeList = (NodeList *) realloc(nodeList, sizeof(struct _nodeList));
-    (nodeList[0]).silminState = createSilminState();
-    (nodeList[0]).node = *nodeIndex;
-    silminState = (nodeList[0]).silminState;
+    }
   }
-  
+
   if (update) {
     int i, j;
     static double *changeBC = NULL;
@@ -2358,7 +3289,16 @@ void meltssaturationstate_(int *nodeIndex, double *pressure, double *bulkComposi
     }
   }
   if (!update) {
-    int i, j;
+    int i, j, k, ns;
+    /* the whole system is put back in the liquid */
+    for (i=0; i<npc; i++) if ((solids[i].type == PHASE) && ((silminState->nSolidCoexist)[i] > 0)) {
+      for (ns=0; ns<(silminState->nSolidCoexist)[i]; ns++) {
+        (silminState->solidComp)[i][ns] = 0.0;
+        if (solids[i].na > 1) for (k=0; k<solids[i].na; k++) (silminState->solidComp)[i+1+k][ns] = 0.0;
+      }
+      (silminState->nSolidCoexist)[i] = 0;
+    }
+    silminState->solidMass = 0.0;
     for (i=0, silminState->liquidMass=0.0; i<nc; i++) {
       (silminState->bulkComp)[i] = bulkComposition[i]/bulkSystem[i].mw;
       silminState->liquidMass += bulkComposition[i];
@@ -175,7 +175,7 @@ double linearSearch(double lambda, int *notcomp)
   int hasLiquid   = (silminState->liquidMass  != 0.0);
 
   if (mSol == NULL) {
-    for (i=0, j=1, k=1; i<npc; i++) if (solids[i].type == PHASE) { j = MAX(j, solids[i].nr); k = MAX(k, solids[i].na); }
+    for (i=0, j=MAX(1, workNr), k=MAX(1, workNa); i<npc; i++) if (solids[i].type == PHASE) { j = MAX(j, solids[i].nr); k = MAX(k, solids[i].na); }
     mSol    = (double  *) malloc((size_t)       k*sizeof(double));
     mLiq    = (double **) malloc((size_t) maxNliq*sizeof(double *));
     mLiqRef = (double **) malloc((size_t) maxNliq*sizeof(double *));
@@ -784,4 +784,95 @@ double linearSearch(double lambda, int *notcomp)
   return pTotal;
 }
 
+/*
+ * Evaluates the potential at n step lengths lambda[0 ... n-1] in one call.
+ * For an isothermal, isobaric and unbuffered system the points share no
+ * state, so the contribution of each solid phase is evaluated for all
+ * feasible points through gmixSolN() and summed into pTotal[].
+ * Otherwise each point is passed to linearSearch() in turn.  notcomp[] is
+ * set as in linearSearch().
+ */
+
+void linearSearchN(int n, double *lambda, double *pTotal, int *notcomp)
+{
+  static double *mSol, *rSol, *rBuf, *gBuf, *mBuf;
+  static int    *kBuf, maxN = 0;
+  double mTotal, pTemp;
+  int i, j, k, l, nk, nl, ns, nr;
+  int hasLiquid = (silminState->liquidMass != 0.0);
+
+  if ( (silminState->fo2Path != FO2_NONE)
+    || ((silminState->refEnthalpy != 0.0) && silminState->isenthalpic)
+    || ((silminState->refEntropy  != 0.0) && silminState->isentropic)
+    || ((silminState->refVolume   != 0.0) && silminState->isochoric) ) {
+    for (k=0; k<n; k++) pTotal[k] = linearSearch(lambda[k], &notcomp[k]);
+    return;
+  }
+
+  if (mSol == NULL) {
+    for (i=0, j=MAX(1, workNr), k=MAX(1, workNa); i<npc; i++) if (solids[i].type == PHASE) { j = MAX(j, solids[i].nr); k = MAX(k, solids[i].na); }
+    mSol = (double *) malloc((size_t) MAX(k, nlc)*sizeof(double));
+    rSol = (double *) malloc((size_t) MAX(j, nlc)*sizeof(double));
+  }
+  if (n > maxN) {
+    for (i=0, j=MAX(1, workNr); i<npc; i++) if (solids[i].type == PHASE) j = MAX(j, solids[i].nr);
+    rBuf = (double *) REALLOC(rBuf, (size_t) j*n*sizeof(double));
+    gBuf = (double *) REALLOC(gBuf, (size_t)   n*sizeof(double));
+    mBuf = (double *) REALLOC(mBuf, (size_t)   n*sizeof(double));
+    kBuf = (int *)    REALLOC(kBuf, (size_t)   n*sizeof(int));
+    maxN = n;
+  }
+
+  for (k=0; k<n; k++) {
+    pTotal[k]  = 0.0;
+    notcomp[k] = (lambda[k] < -2.0 || lambda[k] > 2.0);
+  }
+
+  /* liquid contribution, point by point */
+  if (hasLiquid) for (k=0; k<n; k++) if (!notcomp[k]) {
+    for (nl=0; nl<silminState->nLiquidCoexist; nl++) {
+      for (i=0, mTotal=0.0; i<nlc; i++) {
+        mSol[i] = (silminState->liquidComp)[nl][i] + lambda[k]*(silminState->liquidDelta)[nl][i];
+        mTotal += mSol[i];
+      }
+      if (!testLiq(SIXTH, silminState->T, silminState->P, 0, 0, NULL, NULL, NULL, mSol)) { notcomp[k] = TRUE; break; }
+      for (i=0; i<nlc; i++) pTotal[k] += mSol[i]*(liquid[i].cur).g;
+      conLiq(SECOND, THIRD, silminState->T, silminState->P, NULL, mSol, rSol, NULL, NULL, NULL, NULL);
+      gmixLiq(FIRST, silminState->T, silminState->P, rSol, &pTemp, NULL, NULL);
+      pTotal[k] += mTotal*pTemp;
+    }
+  }
+
+  /* solid contributions, phase by phase over all points */
+  for (i=0; i<npc; i++) for (ns=0; ns<(silminState->nSolidCoexist)[i]; ns++) {
+    if (solids[i].na == 1) {
+      for (k=0; k<n; k++) if (!notcomp[k]) {
+        mTotal = (silminState->solidComp)[i][ns] + lambda[k]*(silminState->solidDelta)[i][ns];
+        if (mTotal < 0.0) notcomp[k] = TRUE;
+        else pTotal[k] += mTotal*(solids[i].cur).g;
+      }
+      continue;
+    }
+
+    nr = solids[i].nr;
+    for (k=0, nk=0; k<n; k++) if (!notcomp[k]) {
+      mTotal = (silminState->solidComp)[i][ns] + lambda[k]*(silminState->solidDelta)[i][ns];
+      if (mTotal < 0.0) { notcomp[k] = TRUE; continue; }
+      for (j=0; j<solids[i].na; j++) mSol[j] = (silminState->solidComp)[i+1+j][ns] + lambda[k]*(silminState->solidDelta)[i+1+j][ns];
+      if ((mTotal > 0.0) && !(*solids[i].test)(SIXTH, silminState->T, silminState->P, 0, 0, NULL, NULL, NULL, mSol)) { notcomp[k] = TRUE; continue; }
+      for (j=0; j<solids[i].na; j++) pTotal[k] += mSol[j]*(solids[i+1+j].cur).g;
+      (*solids[i].convert)(SECOND, THIRD, silminState->T, silminState->P, NULL, mSol, rSol, NULL, NULL, NULL, NULL, NULL);
+      for (j=0; j<nr; j++) rBuf[j*n+nk] = rSol[j];
+      mBuf[nk] = mTotal;
+      kBuf[nk] = k;
+      nk++;
+    }
+    if (nk == 0) continue;
+    gmixSolN(i, FIRST, silminState->T, silminState->P, nk, n, rBuf, gBuf, NULL);
+    for (l=0; l<nk; l++) pTotal[kBuf[l]] += mBuf[l]*gBuf[l];
+  }
+
+  for (k=0; k<n; k++) if (notcomp[k]) pTotal[k] = 0.0;
+}
+
 /* end of file LINEAR_SEARCH.C */
@@ -270,6 +270,11 @@ enum {
 
 int liqERRstate = ERR_NONE;
 
+/* Running count of iterations spent in the speciation (order) loops of the
+   liquid models; silmin() charges it against meltsBudget.                   */
+
+int speciationIterations = 0;
+
 /*
  *===========================================================================
  * Backward compatible liquid functions defined in liquid_v34.c
@@ -11976,6 +11981,7 @@ order(int mask, double t, double p, double r[NR],
     tOld = t;
     pOld = p;
     for (i=0; i<NR; i++) rOld[i] = r[i];
+    speciationIterations += iter;
 
     (void) rANDsTOx (rOld, sOld);
 
@@ -13548,7 +13554,7 @@ hmixLiq(int mask, double t, double p, double *x,
   )
 {
   double *r = x;
-  double s[NT], dsdt[NT];
+  double s[NT];
   int i;
 
   liqERRstate = ERR_NONE;
@@ -13567,8 +13573,9 @@ hmixLiq(int mask, double t, double p, double *x,
   MTHREAD_ONCE(&initThreadBlock, threadInit);
 
   MTHREAD_MUTEX_LOCK(&global_data_mutex);
-  order(FIRST | THIRD, t, p, r,
-        s, NULL, dsdt, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+  /* s only: the SECOND block below gets ds/dt together with ds/dw */
+  order(FIRST, t, p, r,
+        s, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 
   if (mask & FIRST) {
     *hmix = fillG (r, s, t, p) + t*fillS (r, s, t, p);                            /* was: *hmix = fillH (r, s, t, p);  */
@@ -2245,6 +2245,7 @@ order(int mask, double t, double p, double r[NR],
     tOld = t;
     pOld = p;
     for (i=0; i<NR; i++) rOld[i] = r[i];
+    speciationIterations += iter;
 
     (void) rANDsTOx (rOld, sOld);
 
@@ -3498,14 +3499,15 @@ hmixLiq_CO2(int mask, double t, double p, double *x,
   )
 {
   double *r = x;
-  double s[NT], dsdt[NT];
+  double s[NT];
   int i;
 
   MTHREAD_ONCE(&initThreadBlock, threadInit);
 
   MTHREAD_MUTEX_LOCK(&global_data_mutex);
-  order(FIRST | THIRD, t, p, r,
-        s, NULL, dsdt, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+  /* s only: the SECOND block below gets ds/dt together with ds/dw */
+  order(FIRST, t, p, r,
+        s, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
 
   if (mask & FIRST) {
     *hmix = fillG (r, s, t, p) + t*fillS (r, s, t, p);                            /* was: *hmix = fillH (r, s, t, p);  */
@@ -111,6 +111,81 @@ MELTS Source Code: RCS
 #include "status.h"               /*Status of calculation                   */
 #endif
 
+#ifdef BATCH_VERSION
+/*
+ *=============================================================================
+ * Liquidus temperatures found so far, used to start the search for a nearby
+ * composition close to its liquidus (see meltsLiquidusSurrogate in status.h).
+ * A composition is the bulk in wt % oxides with P in kbars appended.
+ */
+
+#define SURROGATE_SIZE      4096 /* liquidus temperatures remembered            */
+#define SURROGATE_NEIGHBORS 6    /* nearest compositions used in a prediction   */
+#define SURROGATE_RADIUS    2.0  /* distance beyond which a neighbor is ignored */
+
+#define SQUARE(x) ((x)*(x))
+
+int meltsLiquidusSurrogate = FALSE;
+
+static int surrogateCount = 0, surrogateNext = 0;
+static double *surrogateX, *surrogateT, *surrogateKey;
+static int *surrogatePath;
+
+static void surrogateComposition(double *x)
+{
+  int i;
+  double total = 0.0;
+
+  for (i=0; i<nc; i++) { x[i] = (silminState->bulkComp)[i]*bulkSystem[i].mw; total += x[i]; }
+  for (i=0; i<nc; i++) x[i] *= 100.0/total;
+  x[nc] = silminState->P/1000.0;
+}
+
+/* Inverse distance weighted mean of the liquidus temperatures of the nearest
+   compositions on the same fO2 path; sigma is their weighted spread          */
+static int surrogatePredict(double *x, double *t, double *sigma)
+{
+  int i, j, k, n = 0, index[SURROGATE_NEIGHBORS];
+  double dist[SURROGATE_NEIGHBORS], sumW = 0.0, sumT = 0.0, sumT2 = 0.0;
+
+  for (i=0; i<surrogateCount; i++) {
+    double d = 0.0, *xi = surrogateX + i*(nc+1);
+    if (surrogatePath[i] != silminState->fo2Path) continue;
+    for (j=0; j<=nc; j++) d += SQUARE(x[j]-xi[j]);
+    d = sqrt(d);
+    if ((d > SURROGATE_RADIUS) || ((n == SURROGATE_NEIGHBORS) && (d >= dist[n-1]))) continue;
+    if (n < SURROGATE_NEIGHBORS) n++;
+    for (k=n-1; k>0 && dist[k-1]>d; k--) { dist[k] = dist[k-1]; index[k] = index[k-1]; }
+    dist[k] = d; index[k] = i;
+  }
+  if (n < 3) return FALSE;
+
+  for (k=0; k<n; k++) {
+    double w = 1.0/(SQUARE(dist[k]) + 1.0e-6);
+    sumW += w; sumT += w*surrogateT[index[k]]; sumT2 += w*SQUARE(surrogateT[index[k]]);
+  }
+  *t = sumT/sumW;
+  *sigma = sqrt(MAX(sumT2/sumW - SQUARE(*t), 0.0));
+  return TRUE;
+}
+
+static void surrogateRecord(double *x, double t)
+{
+  int j;
+
+  if (surrogateX == NULL) {
+    surrogateX    = (double *) malloc((size_t) SURROGATE_SIZE*(nc+1)*sizeof(double));
+    surrogateT    = (double *) malloc((size_t) SURROGATE_SIZE*sizeof(double));
+    surrogatePath = (int *)    malloc((size_t) SURROGATE_SIZE*sizeof(int));
+  }
+  for (j=0; j<=nc; j++) surrogateX[surrogateNext*(nc+1)+j] = x[j];
+  surrogateT[surrogateNext]    = t;
+  surrogatePath[surrogateNext] = silminState->fo2Path;
+  surrogateNext = (surrogateNext + 1) % SURROGATE_SIZE;
+  if (surrogateCount < SURROGATE_SIZE) surrogateCount++;
+}
+#endif /* BATCH_VERSION */
+
 /*
  *=============================================================================
  * Executable code                     
@@ -128,6 +203,10 @@ int liquidus(void)
   static int curStep = 0;
   static int hasSupersaturation, tState = -1;
   static double tInterval;
+#ifdef BATCH_VERSION
+  static double tStep = 50.0;
+  static int bracketed;
+#endif
   int i, j, k, stateChange;
 
 #ifndef BATCH_VERSION
@@ -217,6 +296,21 @@ int liquidus(void)
 
 #ifndef BATCH_VERSION
     workProcData->active = TRUE;
+#else
+    /* Start near a predicted liquidus, stepping by twice its uncertainty */
+    if (tState < 0) {
+      double t, sigma;
+      tStep = 50.0;
+      bracketed = FALSE;
+      if (meltsLiquidusSurrogate) {
+        if (surrogateKey == NULL) surrogateKey = (double *) malloc((size_t) (nc+1)*sizeof(double));
+        surrogateComposition(surrogateKey);
+        if (surrogatePredict(surrogateKey, &t, &sigma)) {
+          silminState->T = t;
+          tStep = MIN(MAX(2.0*sigma, 1.0), 50.0);
+        }
+      }
+    }
 #endif
 
     curStep++;
@@ -300,18 +394,30 @@ int liquidus(void)
     if (tState < 0) {
       stateChange = TRUE;
       tState    = hasSupersaturation;
-      tInterval = (hasSupersaturation) ? 50.0 : -50.0;
 #ifndef BATCH_VERSION
+      tInterval = (hasSupersaturation) ? 50.0 : -50.0;
       workProcData->mode = TRUE;
       tpValues[TP_PADB_INDEX_T_INITIAL].value += tInterval;
 #else
+      tInterval = (hasSupersaturation) ? tStep : -tStep;
       silminState->T += tInterval;
-      if (silminState->T > 2500.0) { meltsStatus.status = LIQUIDUS_MAX_T; return TRUE; }
-      if (silminState->T <  500.0) { meltsStatus.status = LIQUIDUS_MIN_T; return TRUE; }
+      if (silminState->T > 2500.0) { meltsStatus.status = LIQUIDUS_MAX_T; tState = -1; curStep = 0; return TRUE; }
+      if (silminState->T <  500.0) { meltsStatus.status = LIQUIDUS_MIN_T; tState = -1; curStep = 0; return TRUE; }
 #endif
     } else {
       if (tState != hasSupersaturation) { 
         tState = hasSupersaturation; tInterval *= -0.5;
+#ifdef BATCH_VERSION
+        bracketed = TRUE;
+      } else if (!bracketed && (tStep < 50.0)) {
+        /* the prediction was off: widen the step until the liquidus is bracketed */
+        tInterval = (tInterval > 0.0) ? MIN(2.0*tInterval, 50.0) : MAX(2.0*tInterval, -50.0);
+        if ((silminState->T + tInterval > 2500.0) || (silminState->T + tInterval < 500.0)) {
+          meltsStatus.status = (tInterval > 0.0) ? LIQUIDUS_MAX_T : LIQUIDUS_MIN_T;
+          tState = -1; curStep = 0;
+          return TRUE;
+        }
+#endif
       }
       if (fabs(tInterval) > 0.1) {
         stateChange = TRUE;
@@ -327,6 +433,7 @@ int liquidus(void)
 #else
         printf("<> Found the liquidus at T = %.2f (C).\n", silminState->T-273.15);
 	meltsStatus.status = LIQUIDUS_SUCCESS;
+        if (meltsLiquidusSurrogate && (surrogateKey != NULL)) surrogateRecord(surrogateKey, silminState->T);
 #endif
         tState = -1;
       }
@@ -296,7 +296,7 @@ void InitComputeDataStruct(void)
       solids[i].mw = formulaToMwStoich((char *) solids[i].formula, elementsToSolids[i]);
       for(j=0,solids[i].nAtoms=0.0; j<ne; j++) solids[i].nAtoms += elementsToSolids[i][j];
       if (solids[i].type == PHASE) {
-         for (j=i+1; solids[j].type == COMPONENT && j<npc; j++);
+         for (j=i+1; j<npc && solids[j].type == COMPONENT; j++);
          j--;
          solids[i].na = MAX(j-i  , 1);
          solids[i].nr = MAX(j-i-1, 0);
@@ -195,6 +195,93 @@ int min1d(          /* returned value, MODE flag as defined in NASH.H         */
   return MIN1D_SUCCESS;
 }
 
+/******************************************************************************
+ * Variant of Algorithm 17 for functions that can be evaluated at several
+ * points in one call.  Each pass evaluates np equally spaced points about
+ * the current estimate.  If the least value lies at an end of the bracket
+ * the bracket is moved there and widened; otherwise the least value and its
+ * neighbours are fit by a parabola, whose vertex lies within half a spacing
+ * of the least point and is kept only if it lowers the function, and the
+ * bracket is narrowed about the new estimate.  The search ends once the
+ * spacing of a bracket about the minimum is no wider than reltest.
+ ******************************************************************************/
+
+int min1dn(         /* returned value, MODE flag as defined in NASH.H         */
+  int    np,        /* number of points evaluated per pass (at least 3)       */
+  double *bb,       /* initial guess to minimum, resulting minimum position   */
+  double *st,       /* initial and final spacing of the points                */
+  double reltest,   /* maximal |error| allowed in computing value of bb       */
+  int    *ifn,      /* input: maximum No. of func eval; output: actual No.    */
+  double *fnminval, /* minimum function value on return                       */
+  void (*fnnd)(int n, double *bb, double *fn, int *notcomp)) /* fn at n pts   */
+{
+  double *x, *f, *xt, *ft, fii, s1, shrink, xii, x1;
+  int *notcomp, ifnMax = *ifn, centre, k, kmin, n, result = MIN1D_SUCCESS;
+  double BIG = sqrt(DBL_MAX);
+
+  if (np < 3) np = 3;
+  centre  = np/2;
+  x       = (double *) malloc((size_t) 2*(np+1)*sizeof(double));
+  f       = x + np;
+  xt      = f + np;
+  ft      = xt + 1;
+  notcomp = (int *) malloc((size_t) np*sizeof(int));
+
+  *ifn = 0;
+  x1   = *bb;
+  (*fnnd)(1, &x1, &s1, notcomp); (*ifn)++;
+  if (notcomp[0]) { free(x); free(notcomp); return MIN1D_BAD_INITIAL; }
+
+  for (;;) {
+    for (k=0, n=0; k<np; k++) if (k != centre) x[n++] = x1 + (*st)*(k - centre);
+    (*fnnd)(n, x, f, notcomp); (*ifn) += n;
+    for (k=0; k<n; k++) if (notcomp[k]) f[k] = BIG;
+    for (k=np-1; k>centre; k--) { x[k] = x[k-1]; f[k] = f[k-1]; }
+    x[centre] = x1; f[centre] = s1;
+    if (*ifn > ifnMax) { result = MIN1D_ITERS_EXCEEDED; break; }
+
+    for (k=0, kmin=centre; k<np; k++) if (f[k] < f[kmin]) kmin = k;
+
+    if (kmin == 0 || kmin == np-1) {
+      x1 = x[kmin]; s1 = f[kmin];
+      *st *= A1;
+      continue;
+    }
+
+    /* x[kmin-1] .. x[kmin+1] brackets the minimum, stop once it is narrow
+       or the function no longer varies across it beyond roundoff          */
+    if ((*st <= reltest) || ((f[kmin-1] - f[kmin] <= 10.0*DBL_EPSILON*fabs(f[kmin]))
+      && (f[kmin+1] - f[kmin] <= 10.0*DBL_EPSILON*fabs(f[kmin])))) {
+      x1 = x[kmin]; s1 = f[kmin]; break;
+    }
+
+    xii = x[kmin];
+    fii = f[kmin];
+    shrink = (*st)/((double) ((centre > 1) ? centre : 2));
+    {
+      double tt0 = f[kmin-1] - 2.0*f[kmin] + f[kmin+1];
+      if (tt0 > 0.0 && f[kmin-1] < BIG && f[kmin+1] < BIG) {
+        xt[0] = x[kmin] + 0.5*(*st)*((f[kmin-1] - f[kmin+1])/tt0);
+        if (fabs(xt[0]-x[kmin]) > reltest) {
+          (*fnnd)(1, xt, ft, notcomp); (*ifn)++;
+          if (!notcomp[0] && ft[0] < fii) { xii = xt[0]; fii = ft[0]; }
+        }
+        /* the parabola places the minimum about its vertex */
+        if (2.0*fabs(xt[0]-x[kmin]) < shrink) shrink = 2.0*fabs(xt[0]-x[kmin]);
+      }
+    }
+    *st = (shrink > reltest) ? shrink : reltest;
+    x1 = xii; s1 = fii;
+    if (*ifn > ifnMax) { result = MIN1D_ITERS_EXCEEDED; break; }
+  }
+
+  *bb = x1;
+  *fnminval = s1;
+  (*fnnd)(1, bb, &s1, notcomp); /* leaves any state set by fnnd at bb */
+  free(x); free(notcomp);
+  return result;
+}
+
 #undef A1
 #undef A2
 
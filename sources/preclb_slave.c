@@ -83,6 +83,11 @@ extern int sa_(int     *n, double     *x, int     *max, double     *rt, double
   double     *vm, double     *xopt, double     *fopt, int     *nacc, int     *nfcnev,
   int     *nobds, int     *ier, double     *fstar, double     *xp, int     *nacp);
 
+extern int saParallelTempering(int n, double *x, int max, int nChains, double tMin, double tMax, double rt,
+  int ns, int nt, int neps, double eps, int maxevl, double *lb, double *ub, double *c,
+  double *vm, unsigned long seed, int nWorkers, FILE *trace,
+  double *xopt, double *fopt, int *nacc, int *nfcnev, int *nswap);
+
 static double *xLiqSAref, *rLiqSAref, *dgdrLiqSAref, gmixLiqSAref, tSAref, pSAref,
               *xLiqTmp, *rLiqTmp, gmixLiqCur;
 
@@ -986,7 +991,9 @@ void calculateResidualPack(ResidualDataInput *localResidualDataInput, ResidualOu
 			 iseed1SA = 1, 
 			 iseed2SA = 2, 
 			 maxevlSA = 100000, 
-			 iprintSA = 0;
+			 iprintSA = 0,
+			 nChainsSA = -1,
+			 nWorkersSA;
           const int     nepsSA = 4;
 	  static double     tSA, foptSA, *lbSA, *ubSA, *xSA, *xoptSA, *cSA, 
 	                    *vmSA, fstarSA[4], *xpSA,
@@ -1027,7 +1034,24 @@ void calculateResidualPack(ResidualDataInput *localResidualDataInput, ResidualOu
 	  pSAref = p;
 	  dispLiq(FIRST, t, p, rLiq, &liqFormula);
 	  printf("Entering sa %s", liqFormula);
-	  sa_(&nSA, xSA, &maxSA, &rtSA, &epsSA, &nsSA, &ntSA, &nepsSA, &maxevlSA, 
+	  /* MELTS_SA_CHAINS > 1 selects parallel tempering with that many chains, from tSA down to tSA/100,
+	     evaluated by MELTS_SA_WORKERS forked processes (default 1, i.e. in this process)                 */
+	  if (nChainsSA < 0) {
+	    char *environVar;
+	    nChainsSA  = ((environVar = getenv("MELTS_SA_CHAINS"))  != NULL) ? atoi(environVar) : 1;
+	    nWorkersSA = ((environVar = getenv("MELTS_SA_WORKERS")) != NULL) ? atoi(environVar) : 1;
+	  }
+	  ierSA = 99;
+	  if (nChainsSA > 1) {
+	    int nswapSA;
+	    ierSA = saParallelTempering(nSA, xSA, maxSA, nChainsSA, tSA/100.0, tSA, rtSA, nsSA, ntSA, nepsSA, epsSA,
+	      maxevlSA, lbSA, ubSA, cSA, vmSA, (unsigned long) iseed1SA, nWorkersSA, NULL, xoptSA, &foptSA,
+	      &naccSA, &nfcnevSA, &nswapSA);
+	    /* trial points may have been evaluated in the workers, so leave rLiqTmp at the optimum */
+	    if (ierSA != 99) (void) fcn_(&nSA, xoptSA, &foptSA);
+	    else printf(" (parallel tempering workers failed, using sa)");
+	  }
+	  if (ierSA == 99) sa_(&nSA, xSA, &maxSA, &rtSA, &epsSA, &nsSA, &ntSA, &nepsSA, &maxevlSA, 
 	    lbSA, ubSA, cSA, &iprintSA, &iseed1SA, &iseed2SA, &tSA, vmSA, xoptSA, &foptSA, 
 	    &naccSA, &nfcnevSA, &nobdsSA, &ierSA, fstarSA, xpSA, nacpSA);
 	  dispLiq(FIRST, t, p, rLiqTmp, &liqFormula);
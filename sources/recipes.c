@@ -111,6 +111,90 @@ typedef struct {
 #define _HUFFCODE_DECLARE_T_
 #endif /* _HUFFCODE_DECLARE_T_ */
 
+/* ------
+   Optional LAPACK/BLAS backend (build with LAPACK=true)
+
+   gaussj() and svdcmp() hand matrices of order LAPACK_MIN_ORDER and above
+   to LAPACK (e.g. OpenBLAS), copying them through contiguous column-major
+   storage so that blocked, vectorized factorizations can be used.  The
+   routines below that order, and everything when the backend is not
+   built, are the Numerical Recipes reference code.  The small matrices of
+   the solid solution Hessians are faster there.  LAPACK returns singular
+   values in decreasing order rather than in the order of the reference.
+   ------*/
+
+#ifdef USE_LAPACK
+#define LAPACK_MIN_ORDER 64
+
+void dgetrf_(int *m, int *n, double *a, int *lda, int *ipiv, int *info);
+void dgetrs_(char *trans, int *n, int *nrhs, double *a, int *lda, int *ipiv, double *b, int *ldb, int *info);
+void dgetri_(int *n, double *a, int *lda, int *ipiv, double *work, int *lwork, int *info);
+void dgesvd_(char *jobu, char *jobvt, int *m, int *n, double *a, int *lda, double *s, double *u, int *ldu,
+  double *vt, int *ldvt, double *work, int *lwork, int *info);
+
+/* a[1..n][1..n] and b[1..n][1..m] as for gaussj() */
+static void gaussjLapack(double **a, int n, double **b, int m)
+{
+  int i, j, info, lwork = -1, *ipiv = (int *) malloc((size_t) n*sizeof(int));
+  double *lu = (double *) malloc((size_t) n*n*sizeof(double)), query;
+
+  for (j=1; j<=n; j++) for (i=1; i<=n; i++) lu[(i-1)+(j-1)*n] = a[i][j];
+  dgetrf_(&n, &n, lu, &n, ipiv, &info);
+  if (info > 0) {
+    /* as gaussj: returns the identity matrix as inverse instead of aborting */
+    for (i=1; i<=n; i++) {
+      for (j=1; j<=n; j++) a[i][j] = 0.0;
+      a[i][i] = 1.0;
+    }
+  } else {
+    double *work;
+    if (m > 0) {
+      double *x = (double *) malloc((size_t) n*m*sizeof(double));
+      char trans = 'N';
+      for (j=1; j<=m; j++) for (i=1; i<=n; i++) x[(i-1)+(j-1)*n] = b[i][j];
+      dgetrs_(&trans, &n, &m, lu, &n, ipiv, x, &n, &info);
+      for (j=1; j<=m; j++) for (i=1; i<=n; i++) b[i][j] = x[(i-1)+(j-1)*n];
+      free(x);
+    }
+    dgetri_(&n, lu, &n, ipiv, &query, &lwork, &info);
+    lwork = (int) query;
+    work  = (double *) malloc((size_t) lwork*sizeof(double));
+    dgetri_(&n, lu, &n, ipiv, work, &lwork, &info);
+    for (j=1; j<=n; j++) for (i=1; i<=n; i++) a[i][j] = lu[(i-1)+(j-1)*n];
+    free(work);
+  }
+  free(lu);
+  free(ipiv);
+}
+
+/* a[1..m][1..n], w[1..n] and v[1..n][1..n] as for svdcmp(); m >= n.  Returns
+   FALSE, leaving a unchanged, if the decomposition did not converge        */
+static int svdcmpLapack(double **a, int m, int n, double w[], double **v)
+{
+  int i, j, info, lwork = -1;
+  double *x  = (double *) malloc((size_t) m*n*sizeof(double));
+  double *u  = (double *) malloc((size_t) m*n*sizeof(double));
+  double *vt = (double *) malloc((size_t) n*n*sizeof(double));
+  double query, *work;
+  char job = 'S';
+
+  for (j=1; j<=n; j++) for (i=1; i<=m; i++) x[(i-1)+(j-1)*m] = a[i][j];
+  dgesvd_(&job, &job, &m, &n, x, &m, &w[1], u, &m, vt, &n, &query, &lwork, &info);
+  lwork = (int) query;
+  work  = (double *) malloc((size_t) lwork*sizeof(double));
+  dgesvd_(&job, &job, &m, &n, x, &m, &w[1], u, &m, vt, &n, work, &lwork, &info);
+  if (info == 0) {
+    for (j=1; j<=n; j++) for (i=1; i<=m; i++) a[i][j] = u[(i-1)+(j-1)*m];
+    for (j=1; j<=n; j++) for (i=1; i<=n; i++) v[i][j] = vt[(j-1)+(i-1)*n];
+  }
+  free(work);
+  free(vt);
+  free(u);
+  free(x);
+  return (info == 0);
+}
+#endif /* USE_LAPACK */
+
 /* ------
    From COVSRT.C 
    ------*/
@@ -149,6 +233,9 @@ void gaussj(double **a, int n, double **b, int m)
   int i,icol = -1,irow = -1,j,k,l,ll;
   double big,dum,pivinv,temp;
 
+#ifdef USE_LAPACK
+  if (n >= LAPACK_MIN_ORDER) { gaussjLapack(a, n, b, m); return; }
+#endif
   indxc=ivector(1,n);
   indxr=ivector(1,n);
   ipiv=ivector(1,n);
@@ -642,6 +729,9 @@ void svdcmp(double **a, int m, int n, double w[], double **v)
   int flag,i,its,j,jj,k,l,nm;
   double anorm,c,f,g,h,s,scale,x,y,z,*rv1;
 
+#ifdef USE_LAPACK
+  if ((n >= LAPACK_MIN_ORDER) && (m >= n) && svdcmpLapack(a, m, n, w, v)) return;
+#endif
   rv1=vector(1,n);
   g=scale=anorm=0.0;
   for (i=1;i<=n;i++) {
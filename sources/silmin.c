@@ -250,6 +250,7 @@ const char *silmin_ver(void) { return "$Id: silmin.c,v 1.12 2009/04/24 20:51:09
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/time.h>
 
 #include "lawson_hanson.h"        /*func decl for Lawson and Hanson routines*/
 #include "silmin.h"               /*SILMIN structures include file          */
@@ -276,6 +277,13 @@ const char *silmin_ver(void) { return "$Id: silmin.c,v 1.12 2009/04/24 20:51:09
 #undef PRINT_ENERGY_AT_EACH_QUAD_ITERATION
 #endif
 
+/* Compile with -DMULTIPOINT_LINEAR_SEARCH to have the LINEAR_SEARCH step
+   evaluate LINEAR_SEARCH_POINTS step lengths per pass (min1dn/linearSearchN)
+   rather than one at a time (min1d/linearSearch)                          */
+#ifndef LINEAR_SEARCH_POINTS
+#define LINEAR_SEARCH_POINTS 5
+#endif
+
 /*
  *=============================================================================
  * Global variables declared extern in SILMIN.H
@@ -285,6 +293,7 @@ SilminState     *silminState;
 SilminInputData silminInputData = {NULL, NULL};
 SilminHistory   *silminHistory;
 Constraints     *constraints;
+int workNpc = 0, workNa = 0, workNr = 0;
 
 /*
  *=============================================================================
@@ -313,6 +322,147 @@ extern SilminState *previousSilminState;
 SilminState *previousSilminState;
 #endif
 
+/*
+ *=============================================================================
+ * Limits on each equilibration, set by the caller (see status.h)
+ */
+#ifdef BATCH_VERSION
+MeltsBudget meltsBudget = { 0.0, 0, 0 };
+int meltsWarmStart = FALSE;
+void (*meltsStepOutput)(void) = NULL;
+
+static double budgetStart;
+static int budgetQuadIterations, budgetSpeciationStart;
+
+static double wallClock(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double) tv.tv_sec + 1.0e-6*((double) tv.tv_usec);
+}
+
+static void startBudget(void) {
+    budgetStart = (meltsBudget.wallTime > 0.0) ? wallClock() : 0.0;
+    budgetQuadIterations  = 0;
+    budgetSpeciationStart = speciationIterations;
+}
+
+static int budgetExhausted(void) {
+    if ((meltsBudget.quadIterations > 0) && (budgetQuadIterations >= meltsBudget.quadIterations)) return TRUE;
+    if ((meltsBudget.speciationIterations > 0)
+        && (speciationIterations - budgetSpeciationStart >= meltsBudget.speciationIterations)) return TRUE;
+    if ((meltsBudget.wallTime > 0.0) && (wallClock() - budgetStart >= meltsBudget.wallTime)) return TRUE;
+    return FALSE;
+}
+
+/*
+ *=============================================================================
+ * Adaptive steps along a path (see meltsStepControl in status.h)
+ */
+MeltsStepControl meltsStepControl = { FALSE, 0.125, 8.0, 0.05 };
+
+static SilminState *stepState = NULL; /* converged state before the last step */
+static int stepPending = FALSE, stepBracketing = FALSE;
+static int stepsTaken = 0, stepsDiscarded = 0;
+static double stepScale = 1.0;
+static FILE *stepLog = NULL;
+static int stepLogStarted = FALSE;
+
+/* Called when a path ends, which also closes its event log */
+static void resetSteps(void) {
+    stepPending = FALSE; stepBracketing = FALSE;
+    stepsTaken = 0; stepsDiscarded = 0;
+    stepScale = 1.0;
+    if (stepLog != NULL) { fclose(stepLog); stepLog = NULL; }
+}
+
+/* Increment along the path, not passing its end */
+static double stepIncrement(double increment, double remaining) {
+    double step = increment;
+    if (meltsStepControl.adaptive) {
+        step = stepScale*increment;
+        if (step > fabs(remaining)) step = fabs(remaining);
+    }
+    return step;
+}
+
+/* Smallest remaining distance for which another step is taken */
+static double stepMinimum(double increment) {
+    return meltsStepControl.adaptive ? meltsStepControl.minScale*increment : increment;
+}
+
+static double liquidFraction(SilminState *state) {
+    double total = state->liquidMass + state->solidMass;
+    return (total > 0.0) ? state->liquidMass/total : 0.0;
+}
+
+/* Describes the phases that appear in, or drop from, the current assemblage */
+static int assemblageChanged(char *event, size_t len) {
+    int i, changed = FALSE;
+    int hadLiquid = (stepState->liquidMass != 0.0), hasLiquid = (silminState->liquidMass != 0.0);
+
+    event[0] = '\0';
+    if ((hadLiquid != hasLiquid) || (hasLiquid && (stepState->nLiquidCoexist != silminState->nLiquidCoexist))) {
+        snprintf(event, len, "liquid %d -> %d", hadLiquid ? stepState->nLiquidCoexist : 0, hasLiquid ? silminState->nLiquidCoexist : 0);
+        changed = TRUE;
+    }
+    for (i=0; i<npc; i++) if ((solids[i].type == PHASE) && ((stepState->nSolidCoexist)[i] != (silminState->nSolidCoexist)[i])) {
+        size_t used = strlen(event);
+        if (used < len) snprintf(event + used, len - used, "%s%s %d -> %d", changed ? ", " : "", solids[i].label,
+                                 (stepState->nSolidCoexist)[i], (silminState->nSolidCoexist)[i]);
+        changed = TRUE;
+    }
+    return changed;
+}
+
+static void logStep(const char *event) {
+    if (stepLog == NULL) {
+        if ((stepLog = fopen("melts-events.out", stepLogStarted ? "a" : "w")) == NULL) return;
+        if (!stepLogStarted) fprintf(stepLog, "%10s %10s %8s  %s\n", "T (C)", "P (bars)", "step", "event");
+        stepLogStarted = TRUE;
+    }
+    fprintf(stepLog, "%10.3f %10.3f %8.4f  %s\n", silminState->T - 273.15, silminState->P, stepScale, event);
+    fflush(stepLog);
+}
+
+/* Called with a converged state.  Returns TRUE, having restored the state
+   before the step and halved the step, if the step is to be taken again.   */
+static int discardStep(void) {
+    char event[256];
+    int changed;
+    double change;
+
+    if (!meltsStepControl.adaptive || !stepPending) return FALSE;
+    stepPending = FALSE;
+
+    changed = assemblageChanged(event, sizeof(event));
+    change  = fabs(liquidFraction(silminState) - liquidFraction(stepState));
+
+    if ((changed || (change > meltsStepControl.maxChange)) && (stepScale > meltsStepControl.minScale)) {
+        fprintf(stderr, "<> Step of %g increments discarded (%s).\n", stepScale, changed ? event : "rapid change in liquid mass");
+        stepScale = MAX(0.5*stepScale, meltsStepControl.minScale);
+        if (changed) stepBracketing = TRUE;
+        stepsDiscarded++;
+        silminState = copySilminStateStructure(stepState, silminState);
+        return TRUE;
+    }
+
+    stepsTaken++;
+    if (changed) {
+        logStep(event);
+        stepBracketing = FALSE;
+    } else if (stepBracketing) {
+        if (stepScale > meltsStepControl.minScale) stepScale = MAX(0.5*stepScale, meltsStepControl.minScale);
+        else stepBracketing = FALSE;
+    } else if (change < 0.5*meltsStepControl.maxChange) {
+        stepScale = MIN(2.0*stepScale, meltsStepControl.maxScale);
+    }
+    return FALSE;
+}
+#else
+#define stepIncrement(increment, remaining) (increment)
+#define stepMinimum(increment) (increment)
+#endif
+
 /*
  *=============================================================================
  * Executable code
@@ -442,7 +592,24 @@ int silmin(void)
     
     updateStatusADB(STATUS_ADB_INDEX_PHASE, &curStep);
 #else /* BATCH_VERSION */
-    if (curStep == 0) curStep = CHANGE_COMPOSITION;
+    if (curStep == 0) {
+        curStep = CHANGE_COMPOSITION;
+        startBudget();
+        /* a path only continues after a successful step */
+        if (meltsStatus.status != SILMIN_SUCCESS) resetSteps();
+    } else if ((curStep < OUTPUT_RESULTS) && budgetExhausted()) {
+        fprintf(stderr, "...Time or iteration budget exhausted. Aborting.\n");
+        if (acceptable) {
+            fprintf(stderr, "...Returning the best quadratic iterate (iterQuad = %d, rNorm = %g).\n", bestIter, bestrNorm);
+            silminState = copySilminStateStructure(bestState, silminState);
+        }
+        meltsStatus.status = SILMIN_TIME;
+        iterQuad = 0; acceptable = FALSE;
+        curStage = 0;
+        curStep = 0;
+        hasSupersaturation = 0;
+        return TRUE;
+    }
 #endif /* BATCH_VERSION */
     
     if (curStage == 0) curStage = PRE_STAGE_ZERO;
@@ -621,6 +788,11 @@ int silmin(void)
             for (i=0; i<npc; i++) (silminState->cylSolids)[i] = 0;
             
             /* Only call at this stage if we are starting from liquid */
+#ifdef BATCH_VERSION
+            /* A warm start keeps the converged assemblage; VERIFY_SATURATION catches any new phase */
+            if (meltsWarmStart) { meltsWarmStart = FALSE; hasSupersaturation = FALSE; }
+            else
+#endif
             if (hasLiquid) hasSupersaturation = evaluateSaturationState((silminState->ySol), (silminState->yLiq));
             else           hasSupersaturation = FALSE;
             
@@ -872,6 +1044,8 @@ int silmin(void)
             iterQuad++;
 #ifndef BATCH_VERSION
             updateStatusADB(STATUS_ADB_INDEX_QUADRATIC, &iterQuad);
+#else
+            budgetQuadIterations++;
 #endif
             
 #ifdef DEBUG
@@ -1181,7 +1355,11 @@ int silmin(void)
             do {
                 double reltest = MAX(10.0*DBL_EPSILON, DBL_EPSILON*sNorm);
                 iter   = ITERMX;
+#ifdef MULTIPOINT_LINEAR_SEARCH
+                status = min1dn(LINEAR_SEARCH_POINTS, &lambda, &stepSize, reltest, &iter, &pTotal, linearSearchN);
+#else
                 status = min1d(&lambda, &stepSize, reltest, &iter, &pTotal, linearSearch);
+#endif
                 if        (status == MIN1D_BAD_INITIAL) {
                     lambda /= 2.0; /* was 10.0 */
                     if (lambda < DBL_EPSILON) {
@@ -1621,6 +1799,15 @@ int silmin(void)
 #ifndef BATCH_VERSION
             updateUserGraphGW();
 #else
+            if (discardStep()) {
+                curStep = UPDATE_SYSTEM;
+                return FALSE;
+            }
+            if (meltsStepOutput != NULL) {
+                (*meltsStepOutput)();
+                curStep++;
+                return FALSE;
+            }
     if (strstr(silminInputData.name, ".xml")   != NULL) putSequenceDataToXmlFile(TRUE);
 #endif
             
@@ -1642,6 +1829,9 @@ int silmin(void)
             if (oldErrorHandler != NULL && signal(SIGFPE, oldErrorHandler) == SIG_ERR)
                 wprintf(statusEntries[STATUS_ADB_INDEX_STATUS].name, "...Error in installing old signal handler.\n");
             oldErrorHandler = NULL;
+#else
+            /* a discarded step is taken again from this state */
+            if (meltsStepControl.adaptive) stepState = copySilminStateStructure(silminState, stepState);
 #endif
             
             /* Solid Phase Fractionation */
@@ -1906,7 +2096,7 @@ int silmin(void)
             stateChange = FALSE;
             
             /* Changing T ? */
-            if (fabs(silminState->dspTstart - silminState->dspTstop) >=  (silminState->dspTinc != 0.0 ? silminState->dspTinc : 0.001) 
+            if (fabs(silminState->dspTstart - silminState->dspTstop) >=  (silminState->dspTinc != 0.0 ? stepMinimum(silminState->dspTinc) : 0.001) 
                 && !(silminState->isenthalpic && (silminState->refEnthalpy != 0.0))
                 && !(silminState->isentropic  && (silminState->refEntropy  != 0.0))) {
                 stateChange = TRUE;
@@ -1915,10 +2105,11 @@ int silmin(void)
                 if (silminState->dspTstart - silminState->dspTstop < 0.0) tpValues[TP_PADB_INDEX_T_INITIAL].value += silminState->dspTinc;
                 else                                                      tpValues[TP_PADB_INDEX_T_INITIAL].value -= silminState->dspTinc;
 #else
+                double tInc = stepIncrement(silminState->dspTinc, silminState->dspTstart - silminState->dspTstop);
                 if (silminState->dspTstart - silminState->dspTstop < 0.0) {
-                    silminState->T += silminState->dspTinc; silminState->dspTstart += silminState->dspTinc;
+                    silminState->T += tInc; silminState->dspTstart += tInc;
                 } else {
-                    silminState->T -= silminState->dspTinc; silminState->dspTstart -= silminState->dspTinc;
+                    silminState->T -= tInc; silminState->dspTstart -= tInc;
                 }
 #endif
                 /* Changing H ? */
@@ -1992,7 +2183,7 @@ int silmin(void)
 	      }
             }
             /* Changing P ? */
-            if (fabs(silminState->dspPstart - silminState->dspPstop) >=  (silminState->dspPinc != 0.0 ? silminState->dspPinc : 0.001)
+            if (fabs(silminState->dspPstart - silminState->dspPstop) >=  (silminState->dspPinc != 0.0 ? stepMinimum(silminState->dspPinc) : 0.001)
                 && !(silminState->isochoric && (silminState->refVolume != 0.0))) {
                 stateChange = TRUE;
 #ifndef BATCH_VERSION
@@ -2000,10 +2191,11 @@ int silmin(void)
                 if (silminState->dspPstart - silminState->dspPstop < 0.0) tpValues[TP_PADB_INDEX_P_INITIAL].value += silminState->dspPinc;
                 else                                                      tpValues[TP_PADB_INDEX_P_INITIAL].value -= silminState->dspPinc;
 #else
+                double pInc = stepIncrement(silminState->dspPinc, silminState->dspPstart - silminState->dspPstop);
                 if (silminState->dspPstart - silminState->dspPstop < 0.0) {
-                    silminState->P += silminState->dspPinc; silminState->dspPstart += silminState->dspPinc;
+                    silminState->P += pInc; silminState->dspPstart += pInc;
                 } else {
-                    silminState->P -= silminState->dspPinc; silminState->dspPstart -= silminState->dspPinc;
+                    silminState->P -= pInc; silminState->dspPstart -= pInc;
                 }
 #endif
                 /* Changing V ? */
@@ -2046,6 +2238,10 @@ int silmin(void)
             if (silminState->assimilate && silminState->assimMass < silminState->dspAssimMass) {
                 double fraction = 1.0/silminState->dspAssimInc;
                 
+#ifdef BATCH_VERSION
+                if (meltsStepControl.adaptive)
+                    fraction = MIN(stepScale*fraction, 1.0 - silminState->assimMass/silminState->dspAssimMass);
+#endif
                 stateChange = TRUE;
                 silminState->assimMass += fraction*silminState->dspAssimMass;
                 if (silminState->isenthalpic && (silminState->refEnthalpy != 0.0)) silminState->refEnthalpy += fraction*(silminState->assimTD).h;
@@ -2114,6 +2310,13 @@ int silmin(void)
 #else
             meltsStatus.status = SILMIN_SUCCESS;
             if (strstr(silminInputData.name, ".xml")   != NULL) previousSilminState = copySilminStateStructure(silminState, previousSilminState);
+            if (meltsStepControl.adaptive) {
+                if (stateChange) stepPending = TRUE;
+                else {
+                    fprintf(stderr, "<> Adaptive path: %d steps taken, %d discarded.\n", stepsTaken, stepsDiscarded);
+                    resetSteps();
+                }
+            }
 #endif
             
             curStep = 0;
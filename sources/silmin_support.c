@@ -565,6 +565,15 @@ SilminState *copySilminStateStructure(SilminState *pOld, SilminState *pNew)
             (pNew->solidDelta)[i+1+k][j] = (pOld->solidDelta)[i+1+k][j];
           }
       }
+      /* an absent phase is marked by a zero first entry, as in a new copy */
+      if (solids[i].type == PHASE && (pOld->nSolidCoexist)[i] == 0) {
+        pNew->solidComp[i][0]  = 0.0;
+        pNew->solidDelta[i][0] = 0.0;
+        if (solids[i].na > 1) for (k=0; k<solids[i].na; k++) {
+          (pNew->solidComp)[i+1+k][0]  = 0.0;
+          (pNew->solidDelta)[i+1+k][0] = 0.0;
+        }
+      }
       (pNew->nSolidCoexist)[i] = (pOld->nSolidCoexist)[i];
     }
 
@@ -701,6 +710,168 @@ SilminState *copySilminStateStructure(SilminState *pOld, SilminState *pNew)
   return pNew;
 }
 
+/* Default of incSolids[i] in a new state, as set by createSilminState() */
+static int defaultIncSolids(int i) {
+  static int nPhases = -1, nPhasesFor = -1;
+  int j;
+  if (nPhasesFor != npc) {
+    for (j=0, nPhases=0; j<npc; j++) if (solids[j].type == PHASE) nPhases++;
+    nPhasesFor = npc;
+  }
+  return ((i < nPhases) || (i == npc)) ? TRUE : FALSE;
+}
+
+/* Packs the state of the current model into one buffer, which holds no
+   pointers and may be written to a file or pipe; NULL if the state uses
+   arrays that are not packed (assimilation)                                */
+CompactState *packSilminState(SilminState *p) {
+  CompactState header, *c;
+  unsigned char *d, *n;
+  int i, k, ns, nDoubles;
+
+  if (p->assimilate) return NULL;
+
+  memset(&header, 0, sizeof(CompactState));
+  header.nLiquids = MAX(1, p->nLiquidCoexist);
+  nDoubles = 2*nc + 2*header.nLiquids*nlc;
+  for (i=0; i<=npc; i++) if ((p->incSolids)[i] != defaultIncSolids(i)) header.nInc++;
+  for (i=0; i<npc; i++) if ((p->cylSolids)[i] != 0) header.nCyl++;
+  for (i=0; i<npc; i++) if ((p->nSolidCoexist)[i] != 0) header.nSolids++;
+  for (i=0; i<npc; i++) if (((ns = (p->nSolidCoexist)[i]) > 0) && (solids[i].type == PHASE)) {
+    nDoubles += 2*ns*((solids[i].na > 1) ? 1+solids[i].na : 1);
+    if (solids[i].na > 1) i += solids[i].na;
+  }
+  header.nFrac = -1;
+  if (p->fracSComp != NULL) {
+    header.nFrac = 0;
+    for (i=0; i<npc; i++) if ((ns = (p->nFracCoexist)[i]) > 0) {
+      header.nFrac++;
+      nDoubles += ns*((solids[i].na > 1) ? 1+solids[i].na : 1);
+    }
+  }
+  header.hasFracLiq = (p->fracLComp != NULL);
+  if (header.hasFracLiq) nDoubles += nlc;
+
+  header.size = sizeof(CompactState) + (size_t) nDoubles*sizeof(double)
+    + (size_t) 2*(header.nInc + header.nCyl + header.nSolids + MAX(0, header.nFrac))*sizeof(int);
+  c = (CompactState *) malloc(header.size);
+  memcpy(&(header.scalars), p, sizeof(SilminState));
+  memcpy(c, &header, sizeof(CompactState));
+
+  d = (unsigned char *) (c + 1);
+#define PACK_DOUBLES(x, m) { memcpy(d, (x), (size_t) (m)*sizeof(double)); d += (m)*sizeof(double); }
+  n = d + nDoubles*sizeof(double);
+#define PACK_PAIR(j, v) { int pair[2]; pair[0] = (j); pair[1] = (v); memcpy(n, pair, sizeof(pair)); n += sizeof(pair); }
+
+  PACK_DOUBLES(p->bulkComp,    nc);
+  PACK_DOUBLES(p->dspBulkComp, nc);
+  for (i=0; i<header.nLiquids; i++) {
+    PACK_DOUBLES((p->liquidComp)[i],  nlc);
+    PACK_DOUBLES((p->liquidDelta)[i], nlc);
+  }
+  for (i=0; i<npc; i++) if (((ns = (p->nSolidCoexist)[i]) > 0) && (solids[i].type == PHASE)) {
+    PACK_DOUBLES((p->solidComp)[i],  ns);
+    PACK_DOUBLES((p->solidDelta)[i], ns);
+    if (solids[i].na > 1) {
+      for (k=0; k<solids[i].na; k++) {
+        PACK_DOUBLES((p->solidComp)[i+1+k],  ns);
+        PACK_DOUBLES((p->solidDelta)[i+1+k], ns);
+      }
+      i += solids[i].na;
+    }
+  }
+  if (header.nFrac > 0) for (i=0; i<npc; i++) if ((ns = (p->nFracCoexist)[i]) > 0) {
+    PACK_DOUBLES((p->fracSComp)[i], ns);
+    if (solids[i].na > 1) for (k=0; k<solids[i].na; k++) PACK_DOUBLES((p->fracSComp)[i+1+k], ns);
+  }
+  if (header.hasFracLiq) PACK_DOUBLES(p->fracLComp, nlc);
+
+  for (i=0; i<=npc; i++) if ((p->incSolids)[i] != defaultIncSolids(i)) PACK_PAIR(i, (p->incSolids)[i]);
+  for (i=0; i<npc; i++) if ((p->cylSolids)[i] != 0) PACK_PAIR(i, (p->cylSolids)[i]);
+  for (i=0; i<npc; i++) if ((p->nSolidCoexist)[i] != 0) PACK_PAIR(i, (p->nSolidCoexist)[i]);
+  if (header.nFrac > 0) for (i=0; i<npc; i++) if ((p->nFracCoexist)[i] > 0) PACK_PAIR(i, (p->nFracCoexist)[i]);
+#undef PACK_DOUBLES
+#undef PACK_PAIR
+
+  return c;
+}
+
+/* Rebuilds a full state of the current model from a packed one */
+SilminState *unpackSilminState(CompactState *c) {
+  SilminState *p = allocSilminStatePointer(), arrays = *p;
+  unsigned char *d = (unsigned char *) (c + 1), *n;
+  int i, j, k, ns;
+
+  *p = c->scalars;
+  p->bulkComp      = arrays.bulkComp;
+  p->dspBulkComp   = arrays.dspBulkComp;
+  p->liquidComp    = arrays.liquidComp;
+  p->liquidDelta   = arrays.liquidDelta;
+  p->solidComp     = arrays.solidComp;
+  p->nSolidCoexist = arrays.nSolidCoexist;
+  p->solidDelta    = arrays.solidDelta;
+  p->incSolids     = arrays.incSolids;
+  p->cylSolids     = arrays.cylSolids;
+  p->fracSComp     = NULL;
+  p->nFracCoexist  = NULL;
+  p->fracLComp     = NULL;
+  p->ySol          = NULL; /* scratch space, reallocated by silmin() */
+  p->yLiq          = NULL;
+
+  /* the (index, value) pairs follow the doubles, at the end of the buffer */
+  n = (unsigned char *) c + c->size - (size_t) 2*(c->nInc + c->nCyl + c->nSolids + MAX(0, c->nFrac))*sizeof(int);
+#define UNPACK_DOUBLES(x, m) { memcpy((x), d, (size_t) (m)*sizeof(double)); d += (m)*sizeof(double); }
+#define UNPACK_PAIR(j, v) { int pair[2]; memcpy(pair, n, sizeof(pair)); n += sizeof(pair); (j) = pair[0]; (v) = pair[1]; }
+
+  for (i=0; i<=npc; i++) (p->incSolids)[i] = defaultIncSolids(i);
+  for (j=0; j<c->nInc;    j++) { UNPACK_PAIR(i, ns); (p->incSolids)[i]     = ns; }
+  for (j=0; j<c->nCyl;    j++) { UNPACK_PAIR(i, ns); (p->cylSolids)[i]     = ns; }
+  for (j=0; j<c->nSolids; j++) { UNPACK_PAIR(i, ns); (p->nSolidCoexist)[i] = ns; }
+  if (c->nFrac >= 0) {
+    p->fracSComp    = (double **) calloc((size_t) npc, sizeof(double *));
+    p->nFracCoexist = (int *)     calloc((size_t) npc, sizeof(int));
+    for (j=0; j<c->nFrac; j++) { UNPACK_PAIR(i, ns); (p->nFracCoexist)[i] = ns; }
+  }
+
+  UNPACK_DOUBLES(p->bulkComp,    nc);
+  UNPACK_DOUBLES(p->dspBulkComp, nc);
+  if (c->nLiquids > 1) {
+    p->liquidComp  = (double **) realloc(p->liquidComp,  (size_t) c->nLiquids*sizeof(double *));
+    p->liquidDelta = (double **) realloc(p->liquidDelta, (size_t) c->nLiquids*sizeof(double *));
+    for (i=1; i<c->nLiquids; i++) {
+      (p->liquidComp)[i]  = (double *) malloc((size_t) nlc*sizeof(double));
+      (p->liquidDelta)[i] = (double *) malloc((size_t) nlc*sizeof(double));
+    }
+  }
+  for (i=0; i<c->nLiquids; i++) {
+    UNPACK_DOUBLES((p->liquidComp)[i],  nlc);
+    UNPACK_DOUBLES((p->liquidDelta)[i], nlc);
+  }
+  for (i=0; i<npc; i++) if (((ns = (p->nSolidCoexist)[i]) > 0) && (solids[i].type == PHASE)) {
+    for (k=0; k<((solids[i].na > 1) ? 1+solids[i].na : 1); k++) {
+      (p->solidComp)[i+k]  = (double *) realloc((p->solidComp)[i+k],  (size_t) ns*sizeof(double));
+      (p->solidDelta)[i+k] = (double *) realloc((p->solidDelta)[i+k], (size_t) ns*sizeof(double));
+      UNPACK_DOUBLES((p->solidComp)[i+k],  ns);
+      UNPACK_DOUBLES((p->solidDelta)[i+k], ns);
+    }
+    if (solids[i].na > 1) i += solids[i].na;
+  }
+  if (c->nFrac > 0) for (i=0; i<npc; i++) if ((ns = (p->nFracCoexist)[i]) > 0) {
+    for (k=0; k<((solids[i].na > 1) ? 1+solids[i].na : 1); k++) {
+      (p->fracSComp)[i+k] = (double *) malloc((size_t) ns*sizeof(double));
+      UNPACK_DOUBLES((p->fracSComp)[i+k], ns);
+    }
+  }
+  if (c->hasFracLiq) {
+    p->fracLComp = (double *) malloc((size_t) nlc*sizeof(double));
+    UNPACK_DOUBLES(p->fracLComp, nlc);
+  }
+#undef UNPACK_DOUBLES
+#undef UNPACK_PAIR
+
+  return p;
+}
+
 #ifndef BATCH_VERSION
 
 #define ERROR(string) \
@@ -2079,4 +2250,29 @@ int addOrDropLiquid(double *deltaBulkComp) {
   return result;
 }
 
+/*************************************************************************
+   Evaluation of (*gmix) for n compositions of solid phase index.
+   Compositions and results are stored by variable, i.e. x[j*ld+k] is
+   variable j of composition k. Only the FIRST and SECOND mask bits are
+   recognized.
+*************************************************************************/
+
+void gmixSolN(int index, int mask, double t, double p, int n, int ld,
+  double *x, double *gmix, double *dx)
+{
+  double *xk, *dxk, g;
+  int j, k, nr;
+
+  nr  = solids[index].nr;
+  xk  = (double *) malloc((size_t) 2*nr*sizeof(double));
+  dxk = xk + nr;
+  for (k=0; k<n; k++) {
+    for (j=0; j<nr; j++) xk[j] = x[j*ld+k];
+    (*solids[index].gmix)(mask & (FIRST | SECOND), t, p, xk, &g, dxk, NULL, NULL);
+    if (mask & FIRST)  gmix[k] = g;
+    if (mask & SECOND) for (j=0; j<nr; j++) dx[j*ld+k] = dxk[j];
+  }
+  free(xk);
+}
+
 /* end of file SILMIN_SUPPORT.C */
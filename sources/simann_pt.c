@@ -0,0 +1,321 @@
+/*
+**++
+**  FACILITY:  Silicate Melts Regression/Crystallization Package
+**
+**  MODULE DESCRIPTION:
+**
+**      Parallel tempering variant of simulated annealing (file: SIMANN_PT.C)
+**
+**      saParallelTempering() minimizes (or maximizes) the same function
+**      fcn_(n, x, f) that SA (simann.f) calls, with a population of chains
+**      at temperatures spaced geometrically from tMin to tMax.  Each
+**      round perturbs one coordinate of every chain, as a step of SA does,
+**      evaluates the trial points of all chains together and applies the
+**      Metropolis criterion of each chain at its own temperature.  After
+**      every sweep through the coordinates adjacent chains attempt to
+**      exchange their points.  Step lengths are adjusted every ns sweeps by
+**      the rule of SA, with the acceptance ratio of each chain, and after
+**      each stage of ns*nt sweeps all temperatures are multiplied by rt
+**      (1 for plain parallel tempering; below 1 the ladder cools as SA
+**      does).  The search stops when the point of the coldest chain has
+**      stayed within eps of the best point over the last neps stages, or
+**      after maxevl evaluations.
+**
+**      Trial points are evaluated by worker processes forked on entry, so
+**      each has its own copy of whatever model state fcn_() uses; fcn_()
+**      must depend on its arguments alone once this routine is called.
+**      Each evaluation then costs a round trip through a pipe, so workers
+**      only pay when fcn_() is much slower than that; with nWorkers <= 1
+**      points are evaluated in the calling process.
+**      Every chain, and the exchange of points, draws from its own random
+**      stream seeded from the seed and its number, and the trial points of
+**      a round are assigned to workers in chain order; the result therefore
+**      does not depend on the number of workers.  If trace is not NULL each
+**      accepted move and each exchange is written to it as a line of CSV.
+**
+**      Returns 0 on convergence, 1 if maxevl was reached, 2 if x is outside
+**      the bounds, 3 if the temperatures are not positive and increasing,
+**      and 99 if a worker could not be started or died.
+**--
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef MINGW
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+extern int fcn_(int *n, double *theta, double *h);
+
+/* largest argument of exp() in the acceptance tests, as in EXPREP of SA */
+#define SA_EXP_MAX 174.0
+
+/* xorshift64* generator; the state must be non-zero */
+static double ptUniform(unsigned long long *state)
+{
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return (double) ((*state * 2685821657736338717ULL) >> 11)/9007199254740992.0;
+}
+
+static void ptSeed(unsigned long long *state, unsigned long seed, int stream)
+{
+  int i;
+  *state = 0x9e3779b97f4a7c15ULL*((unsigned long long) seed + 1) ^ (0xbf58476d1ce4e5b9ULL*((unsigned long long) stream + 1));
+  if (*state == 0) *state = 1;
+  for (i=0; i<8; i++) (void) ptUniform(state);
+}
+
+static int ptAccept(double dE, double t, unsigned long long *state)
+{
+  double u = ptUniform(state);
+  if (dE <= 0.0) return 1;
+  if (dE/t > SA_EXP_MAX) return 0;
+  return (u < exp(-dE/t));
+}
+
+#ifndef MINGW
+
+typedef struct _ptWorker {
+  pid_t pid;
+  int   taskFd;
+  int   resultFd;
+} PtWorker;
+
+static int ptWriteFully(int fd, void *buffer, size_t size)
+{
+  size_t n = 0;
+  while (n < size) {
+    ssize_t m = write(fd, (char *) buffer + n, size - n);
+    if (m <= 0) return 0;
+    n += (size_t) m;
+  }
+  return 1;
+}
+
+static int ptReadFully(int fd, void *buffer, size_t size)
+{
+  size_t n = 0;
+  while (n < size) {
+    ssize_t m = read(fd, (char *) buffer + n, size - n);
+    if (m <= 0) return 0;
+    n += (size_t) m;
+  }
+  return 1;
+}
+
+static void ptWorkerLoop(int n, int taskFd, int resultFd)
+{
+  double *x = (double *) malloc((size_t) n*sizeof(double)), f;
+  int go;
+
+  while (ptReadFully(taskFd, &go, sizeof(int)) && go && ptReadFully(taskFd, x, (size_t) n*sizeof(double))) {
+    (void) fcn_(&n, x, &f);
+    if (!ptWriteFully(resultFd, &f, sizeof(double))) break;
+  }
+  _exit(0);
+}
+
+static int ptStartWorkers(int n, PtWorker *pool, int nWorkers)
+{
+  int toWorker[2], toParent[2], i, j;
+
+  (void) fflush(stdout);
+  for (i=0; i<nWorkers; i++) {
+    if ((pipe(toWorker) != 0) || (pipe(toParent) != 0)) return 0;
+    if ((pool[i].pid = fork()) < 0) return 0;
+    if (pool[i].pid == 0) {
+      for (j=0; j<i; j++) { close(pool[j].taskFd); close(pool[j].resultFd); }
+      close(toWorker[1]);
+      close(toParent[0]);
+      ptWorkerLoop(n, toWorker[0], toParent[1]);
+    }
+    close(toWorker[0]);
+    close(toParent[1]);
+    pool[i].taskFd   = toWorker[1];
+    pool[i].resultFd = toParent[0];
+  }
+  return 1;
+}
+
+static void ptStopWorkers(PtWorker *pool, int nWorkers)
+{
+  int i, stop = 0;
+  for (i=0; i<nWorkers; i++) if (pool[i].pid > 0) {
+    (void) ptWriteFully(pool[i].taskFd, &stop, sizeof(int));
+    close(pool[i].taskFd);
+    close(pool[i].resultFd);
+    waitpid(pool[i].pid, NULL, 0);
+  }
+}
+
+#endif /* MINGW */
+
+/* Evaluates the trial points xp[k] of all chains into fp[k]; chain k goes
+   to worker k % nWorkers, nWorkers trial points at a time               */
+static int ptEvaluate(int n, int nChains, double **xp, double *fp, void *workers, int nWorkers)
+{
+  int k;
+#ifndef MINGW
+  PtWorker *pool = (PtWorker *) workers;
+  int go = 1, m;
+
+  if (nWorkers > 1) {
+    for (k=0; k<nChains; k+=nWorkers) {
+      for (m=0; (m<nWorkers) && (k+m<nChains); m++)
+        if (!ptWriteFully(pool[m].taskFd, &go, sizeof(int)) || !ptWriteFully(pool[m].taskFd, xp[k+m], (size_t) n*sizeof(double))) return 0;
+      for (m=0; (m<nWorkers) && (k+m<nChains); m++)
+        if (!ptReadFully(pool[m].resultFd, &fp[k+m], sizeof(double))) return 0;
+    }
+    return 1;
+  }
+#endif
+  for (k=0; k<nChains; k++) (void) fcn_(&n, xp[k], &fp[k]);
+  return 1;
+}
+
+int saParallelTempering(int n, double *x, int max, int nChains, double tMin, double tMax, double rt,
+  int ns, int nt, int neps, double eps, int maxevl, double *lb, double *ub, double *c,
+  double *vm, unsigned long seed, int nWorkers, FILE *trace,
+  double *xopt, double *fopt, int *nacc, int *nfcnev, int *nswap)
+{
+  unsigned long long *stream, swapStream;
+  double **xc, **xp, **vmc, *ec, *fp, *t, *fstar, e0;
+  int **nacp, ier = 0, quit = 0, round = 0, sweep, stage, h, i, k, m;
+  void *workers = NULL;
+#ifndef MINGW
+  PtWorker *pool = NULL;
+  void (*oldPipeHandler)(int) = SIG_DFL;
+#endif
+
+  *nacc = 0; *nfcnev = 0; *nswap = 0;
+  if ((tMin <= 0.0) || (tMax < tMin) || (rt <= 0.0) || (nChains < 1)) return 3;
+  for (i=0; i<n; i++) if ((x[i] < lb[i]) || (x[i] > ub[i])) return 2;
+  if (nChains == 1) tMax = tMin;
+#ifdef MINGW
+  nWorkers = 1;
+#else
+  if (nWorkers > nChains) nWorkers = nChains;
+  if (nWorkers > 1) {
+    pool = (PtWorker *) calloc((size_t) nWorkers, sizeof(PtWorker));
+    oldPipeHandler = signal(SIGPIPE, SIG_IGN);
+    if (!ptStartWorkers(n, pool, nWorkers)) { ptStopWorkers(pool, nWorkers); free(pool); signal(SIGPIPE, oldPipeHandler); return 99; }
+    workers = pool;
+  }
+#endif
+
+  stream = (unsigned long long *) malloc((size_t) nChains*sizeof(unsigned long long));
+  xc     = (double **) malloc((size_t) nChains*sizeof(double *));
+  xp     = (double **) malloc((size_t) nChains*sizeof(double *));
+  vmc    = (double **) malloc((size_t) nChains*sizeof(double *));
+  nacp   = (int **)    malloc((size_t) nChains*sizeof(int *));
+  ec     = (double *)  malloc((size_t) nChains*sizeof(double));
+  fp     = (double *)  malloc((size_t) nChains*sizeof(double));
+  t      = (double *)  malloc((size_t) nChains*sizeof(double));
+  fstar  = (double *)  malloc((size_t) (neps > 0 ? neps : 1)*sizeof(double));
+
+  /* the energy minimized is -f when maximizing, as SA does internally */
+  (void) fcn_(&n, x, &e0);
+  (*nfcnev)++;
+  if (max) e0 = -e0;
+  for (k=0; k<nChains; k++) {
+    xc[k]   = (double *) malloc((size_t) n*sizeof(double));
+    xp[k]   = (double *) malloc((size_t) n*sizeof(double));
+    vmc[k]  = (double *) malloc((size_t) n*sizeof(double));
+    nacp[k] = (int *)    calloc((size_t) n, sizeof(int));
+    memcpy(xc[k],  x,  (size_t) n*sizeof(double));
+    memcpy(vmc[k], vm, (size_t) n*sizeof(double));
+    ec[k] = e0;
+    t[k]  = (nChains > 1) ? tMin*pow(tMax/tMin, (double) k/(double) (nChains-1)) : tMin;
+    ptSeed(&stream[k], seed, k);
+  }
+  ptSeed(&swapStream, seed, nChains);
+  memcpy(xopt, x, (size_t) n*sizeof(double));
+  *fopt = e0;
+  for (i=0; i<neps; i++) fstar[i] = HUGE_VAL;
+  if (trace != NULL) {
+    fprintf(trace, "round,event,chain,temperature,f");
+    for (i=0; i<n; i++) fprintf(trace, ",x%d", i+1);
+    fprintf(trace, "\n");
+  }
+
+  for (stage=0; !quit; stage++) {
+    for (m=0; (m<nt) && !quit; m++) {
+      for (sweep=0; (sweep<ns) && !quit; sweep++) {
+        for (h=0; (h<n) && !quit; h++, round++) {
+          /* trial points, one coordinate moved, out of bounds redrawn in [lb, ub] */
+          for (k=0; k<nChains; k++) {
+            memcpy(xp[k], xc[k], (size_t) n*sizeof(double));
+            xp[k][h] = xc[k][h] + (2.0*ptUniform(&stream[k]) - 1.0)*vmc[k][h];
+            if ((xp[k][h] < lb[h]) || (xp[k][h] > ub[h])) xp[k][h] = lb[h] + (ub[h] - lb[h])*ptUniform(&stream[k]);
+          }
+          if (!ptEvaluate(n, nChains, xp, fp, workers, nWorkers)) { ier = 99; quit = 1; break; }
+          *nfcnev += nChains;
+
+          for (k=0; k<nChains; k++) {
+            double ep = max ? -fp[k] : fp[k];
+            if (ptAccept(ep - ec[k], t[k], &stream[k])) {
+              memcpy(xc[k], xp[k], (size_t) n*sizeof(double));
+              ec[k] = ep;
+              nacp[k][h]++;
+              (*nacc)++;
+              if (ep < *fopt) { *fopt = ep; memcpy(xopt, xp[k], (size_t) n*sizeof(double)); }
+              if (trace != NULL) {
+                fprintf(trace, "%d,accept,%d,%g,%.10g", round, k, t[k], max ? -ep : ep);
+                for (i=0; i<n; i++) fprintf(trace, ",%.10g", xp[k][i]);
+                fprintf(trace, "\n");
+              }
+            }
+          }
+          if ((maxevl > 0) && (*nfcnev >= maxevl)) { ier = 1; quit = 1; }
+        }
+
+        /* exchanges between adjacent temperatures, even and odd pairs in turn */
+        for (k=(round/n) % 2; !quit && (k+1<nChains); k+=2) {
+          double dE = (ec[k] - ec[k+1])*(1.0/t[k+1] - 1.0/t[k]);
+          if (ptAccept(dE, 1.0, &swapStream)) {
+            double *swap = xc[k], e = ec[k];
+            xc[k] = xc[k+1]; xc[k+1] = swap;
+            ec[k] = ec[k+1]; ec[k+1] = e;
+            (*nswap)++;
+            if (trace != NULL) fprintf(trace, "%d,exchange,%d,%g,%.10g\n", round, k, t[k], max ? -ec[k] : ec[k]);
+          }
+        }
+      }
+
+      /* step lengths from the acceptance ratio of each chain, as in SA */
+      for (k=0; !quit && (k<nChains); k++) for (i=0; i<n; i++) {
+        double ratio = (double) nacp[k][i]/(double) ns;
+        if      (ratio > 0.6) vmc[k][i] *= 1.0 + c[i]*(ratio - 0.6)/0.4;
+        else if (ratio < 0.4) vmc[k][i] /= 1.0 + c[i]*((0.4 - ratio)/0.4);
+        if (vmc[k][i] > ub[i] - lb[i]) vmc[k][i] = ub[i] - lb[i];
+        nacp[k][i] = 0;
+      }
+    }
+    if (quit) break;
+
+    /* converged when the coldest chain has settled on the best point */
+    for (i=neps-1; i>0; i--) fstar[i] = fstar[i-1];
+    if (neps > 0) fstar[0] = ec[0];
+    for (i=0, quit=(neps > 0) && (fabs(ec[0] - *fopt) <= eps); quit && (i<neps); i++)
+      if (fabs(ec[0] - fstar[i]) > eps) quit = 0;
+    for (k=0; k<nChains; k++) t[k] *= rt;
+  }
+
+  if (max) *fopt = -(*fopt);
+  memcpy(vm, vmc[0], (size_t) n*sizeof(double));
+
+#ifndef MINGW
+  if (pool != NULL) { ptStopWorkers(pool, nWorkers); free(pool); signal(SIGPIPE, oldPipeHandler); }
+#endif
+  for (k=0; k<nChains; k++) { free(xc[k]); free(xp[k]); free(vmc[k]); free(nacp[k]); }
+  free(stream); free(xc); free(xp); free(vmc); free(nacp); free(ec); free(fp); free(t); free(fstar);
+  return ier;
+}
@@ -160,6 +160,7 @@ int subsolidusmuO2(int mask,
   double *m , *r, *activities;
   double **stMatrix, *dstoich, *RHS;
   static double *olddstoich;
+  static Solids *oldSolids;
   double fudge = 1.0, error0 = 0.0, molesO2 = 0.0;
   int iter = 0;
 
@@ -220,6 +221,7 @@ int subsolidusmuO2(int mask,
     /* Decide whether a new reaction is needed */
     acceptable = TRUE;
     if (olddstoich != NULL) {
+      acceptable = acceptable && (solids == oldSolids);
       acceptable = acceptable && (n  == oldN);
       acceptable = acceptable && (mm == oldMm);
       for (i=2;i<MIN(n, oldN);i++) {
@@ -283,7 +285,7 @@ int subsolidusmuO2(int mask,
 	oldPhaseIndex[i] = phaseIndex[i];
 	oldNCoexist[i]   = nCoexist[i];
       }
-      oldN = n; oldMm = mm;
+      oldN = n; oldMm = mm; oldSolids = solids;
     } else {	/* use reaction from last time */
       dstoich = vector(1, n);
       for (i=1; i<=n; i++) dstoich[i] = olddstoich[i];
@@ -0,0 +1,502 @@
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* Checks the stream (-stream), server (-socket), ensemble (-ensemble) and
+   pseudosection (-pseudosection) modes of Melts-batch, and adaptive steps
+   along the path of a .melts input.  Two MELTSinput documents at different
+   temperatures are processed one after the other in one stream run and
+   through one server connection, and the results must be those of each
+   document processed by a Melts-batch of its own.  An ensemble and a
+   pseudosection must give the same results on any number of workers, and a
+   refined pseudosection the results of its finest grid.  Run from the
+   directory holding MELTSinput.xsd; the Melts-batch executable is
+   ./Melts-batch unless given as the first argument.  The runs are made in a
+   scratch directory, which is left behind on failure.                      */
+
+#define N_DOCS 2
+
+static const char *document =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  "<MELTSinput>\n"
+  "  <initialize>\n"
+  "    <SiO2>48.68</SiO2><TiO2>1.01</TiO2><Al2O3>17.64</Al2O3><Fe2O3>0.89</Fe2O3><Cr2O3>0.0425</Cr2O3><FeO>7.59</FeO>"
+  "<MgO>9.10</MgO><CaO>12.45</CaO><Na2O>2.65</Na2O><K2O>0.03</K2O><P2O5>0.08</P2O5><H2O>0.20</H2O>\n"
+  "  </initialize>\n"
+  "  <calculationMode>equilibrate</calculationMode>\n"
+  "  <title>%s</title>\n"
+  "  <constraints><setTP><initialT>%g</initialT><finalT>%g</finalT><incT>1</incT>"
+  "<initialP>1000</initialP><finalP>1000</finalP><incP>0</incP></setTP></constraints>\n"
+  "</MELTSinput>\n";
+
+static const char  *title[N_DOCS] = { "first", "second" };
+static const double t[N_DOCS]     = { 1200.0, 1150.0 };
+
+static char *readFile(const char *name) {
+  FILE *fp = fopen(name, "r");
+  char *buffer;
+  long len;
+
+  if (fp == NULL) return NULL;
+  (void) fseek(fp, 0L, SEEK_END);
+  len = ftell(fp);
+  rewind(fp);
+  buffer = (char *) malloc((size_t) len + 1);
+  len = (long) fread(buffer, 1, (size_t) len, fp);
+  buffer[len] = '\0';
+  fclose(fp);
+  return buffer;
+}
+
+static int writeFile(const char *name, const char *text) {
+  FILE *fp = fopen(name, "w");
+  if (fp == NULL) return 0;
+  (void) fputs(text, fp);
+  return (fclose(fp) == 0);
+}
+
+/* the run date and time are the only things that differ from run to run */
+static void maskTime(char *text) {
+  char *from = text, *to = text, *tag;
+
+  while ((tag = strstr(from, "<time>")) != NULL) {
+    char *end = strstr(tag, "</time>");
+    size_t len = (size_t) (tag - from) + strlen("<time>");
+    if (end == NULL) break;
+    (void) memmove(to, from, len);
+    to += len;
+    from = end;
+  }
+  (void) memmove(to, from, strlen(from)+1);
+}
+
+static int sameOutput(const char *what, char *expected, char *result) {
+  if ((expected == NULL) || (result == NULL)) {
+    printf("%-40s no output ... FAILED\n", what);
+    return 0;
+  }
+  maskTime(expected); /* in place, and again harmlessly on later calls */
+  maskTime(result);
+  if (strcmp(expected, result)) {
+    printf("%-40s differs ... FAILED\n", what);
+    return 0;
+  }
+  printf("%-40s same\n", what);
+  return 1;
+}
+
+static char meltsBatch[PATH_MAX];
+
+/* runs Melts-batch with the arguments given, discarding what it prints */
+static int runBatch(const char *arguments) {
+  char command[3*PATH_MAX];
+  (void) snprintf(command, sizeof(command), "%s %s > /dev/null 2>&1", meltsBatch, arguments);
+  return (system(command) == 0);
+}
+
+static int runStream(const char *input, const char *output) {
+  char arguments[PATH_MAX];
+  (void) snprintf(arguments, sizeof(arguments), "-stream %s %s", input, output);
+  return runBatch(arguments);
+}
+
+static int readFully(int fd, char *buffer, size_t len) {
+  while (len > 0) {
+    ssize_t n = read(fd, buffer, len);
+    if ((n < 0) && (errno == EINTR)) continue;
+    if (n <= 0) return 0;
+    buffer += n; len -= (size_t) n;
+  }
+  return 1;
+}
+
+/* reads one reply document, framed by its length on a line of its own */
+static int readReply(int fd, char **reply, size_t *used) {
+  char header[32];
+  size_t i;
+  long len;
+
+  for (i=0; i<sizeof(header)-1; i++) {
+    if (!readFully(fd, &header[i], 1)) return 0;
+    if (header[i] == '\n') break;
+  }
+  header[i] = '\0';
+  if ((len = strtol(header, NULL, 10)) < 0) return 0;
+  *reply = (char *) realloc(*reply, *used + (size_t) len + 1);
+  if (!readFully(fd, &(*reply)[*used], (size_t) len)) return 0;
+  *used += (size_t) len;
+  (*reply)[*used] = '\0';
+  return 1;
+}
+
+/* sends all of the documents before reading the replies */
+static char *runServer(char *docs[]) {
+  struct sockaddr_un addr;
+  char *reply = NULL;
+  size_t used = 0;
+  int i, fd = -1, ok = 1;
+  pid_t pid;
+
+  (void) fflush(stdout);
+  if ((pid = fork()) == 0) {
+    (void) freopen("/dev/null", "w", stdout);
+    (void) freopen("/dev/null", "w", stderr);
+    (void) execl(meltsBatch, meltsBatch, "-socket", "server.sock", (char *) NULL);
+    _exit(1);
+  }
+  if (pid < 0) return NULL;
+
+  (void) memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  (void) strcpy(addr.sun_path, "server.sock");
+  for (i=0; i<300; i++) { /* up to 30 s for the server to start listening */
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) break;
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) break;
+    close(fd); fd = -1;
+    (void) usleep(100000);
+  }
+
+  if (fd >= 0) {
+    for (i=0; (i<N_DOCS) && ok; i++) {
+      char header[32];
+      int len = snprintf(header, sizeof(header), "%d\n", (int) strlen(docs[i]));
+      ok = (write(fd, header, (size_t) len) == len) && (write(fd, docs[i], strlen(docs[i])) == (ssize_t) strlen(docs[i]));
+    }
+    for (i=0; (i<N_DOCS) && ok; i++) ok = readReply(fd, &reply, &used) && readReply(fd, &reply, &used);
+    close(fd);
+  } else ok = 0;
+
+  (void) kill(pid, SIGTERM);
+  (void) waitpid(pid, NULL, 0);
+  if (!ok) { free(reply); return NULL; }
+  return reply;
+}
+
+/* Two documents one after the other, in one stream run and over one server
+   connection, must give the output of each document run on its own        */
+static int testStreamAndServer(void) {
+  char *docs[N_DOCS], *both, *expected = NULL, *result;
+  size_t used = 0;
+  int i, passed = 1;
+
+  for (i=0; i<N_DOCS; i++) {
+    char input[32], output[32], *single;
+    size_t len = strlen(document) + 64;
+
+    docs[i] = (char *) malloc(len);
+    (void) snprintf(docs[i], len, document, title[i], t[i], t[i]);
+    (void) snprintf(input,  sizeof(input),  "single%d.xml", i);
+    (void) snprintf(output, sizeof(output), "single%d-out.xml", i);
+    if (!writeFile(input, docs[i]) || !runStream(input, output) || ((single = readFile(output)) == NULL)) {
+      printf("Stream run of document %d alone failed ... FAILED\n", i+1);
+      passed = 0;
+      continue;
+    }
+    expected = (char *) realloc(expected, used + strlen(single) + 1);
+    (void) strcpy(&expected[used], single);
+    used += strlen(single);
+    free(single);
+  }
+
+  if (passed) {
+    both = (char *) malloc(strlen(docs[0]) + strlen(docs[1]) + 1);
+    (void) strcat(strcpy(both, docs[0]), docs[1]);
+    result = (writeFile("both.xml", both) && runStream("both.xml", "both-out.xml")) ? readFile("both-out.xml") : NULL;
+    passed &= sameOutput("Stream run of both documents", expected, result);
+    free(result);
+    free(both);
+
+    result = runServer(docs);
+    passed &= sameOutput("Server run of both documents", expected, result);
+    free(result);
+  }
+
+  for (i=0; i<N_DOCS; i++) free(docs[i]);
+  free(expected);
+  return passed;
+}
+
+/* The members of an ensemble draw their perturbations from the seed and their
+   own number, so the statistics must not depend on the number of workers; and
+   without perturbations every member follows the same path                 */
+static const char *ensembleInput =
+  "Title: MORB ensemble\n"
+  "Initial Composition: SiO2 48.68\nInitial Composition: TiO2 1.01\nInitial Composition: Al2O3 17.64\n"
+  "Initial Composition: Fe2O3 0.89\nInitial Composition: Cr2O3 0.0425\nInitial Composition: FeO 7.59\n"
+  "Initial Composition: MgO 9.10\nInitial Composition: CaO 12.45\nInitial Composition: Na2O 2.65\n"
+  "Initial Composition: K2O 0.03\nInitial Composition: P2O5 0.08\nInitial Composition: H2O 0.2\n"
+  "Initial Temperature: 1260.00\nFinal Temperature: 1200.00\nIncrement Temperature: 20.00\n"
+  "Initial Pressure: 1000.00\nFinal Pressure: 1000.00\nIncrement Pressure: 0.00\n"
+  "log fo2 Path: FMQ\nMode: Fractionate Solids\n";
+
+static const char *ensemblePerturbations =
+  "Members: 6\nWorkers: %d\nSeed: 3\nRelative Composition Error: 1.0\nLog fO2 Error: 0.2\nPressure Error: 100\n";
+
+static int testEnsemble(void) {
+  char perturbations[256], *one, *three, *line;
+  int rows = 0, passed = 1;
+
+  (void) snprintf(perturbations, sizeof(perturbations), ensemblePerturbations, 1);
+  passed &= writeFile("ensemble.melts", ensembleInput) && writeFile("one.txt", perturbations);
+  (void) snprintf(perturbations, sizeof(perturbations), ensemblePerturbations, 3);
+  passed &= writeFile("three.txt", perturbations) && writeFile("none.txt", "Members: 4\nWorkers: 2\n");
+  passed &= runBatch("-ensemble ensemble.melts one.txt one.csv") && runBatch("-ensemble ensemble.melts three.txt three.csv");
+  passed &= runBatch("-ensemble ensemble.melts none.txt none.csv");
+  if (!passed) {
+    printf("%-40s failed ... FAILED\n", "Ensemble runs");
+    return 0;
+  }
+
+  one   = readFile("one.csv");
+  three = readFile("three.csv");
+  passed &= sameOutput("Ensemble run on 1 and on 3 workers", one, three);
+  free(one);
+  free(three);
+
+  /* skip the header, then n,mean,sd,q05,...,q95 end each row */
+  one = readFile("none.csv");
+  for (line = (one != NULL) ? strchr(one, '\n') : NULL; (line != NULL) && (line[1] != '\0'); line = strchr(line+1, '\n')) {
+    double mean, sd, q[5];
+    char *field = line+1;
+    int n, k;
+    for (k=0; (k<4) && (field != NULL); k++) if ((field = strchr(field, ',')) != NULL) field++;
+    if ((field == NULL) || (sscanf(field, "%d,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &n, &mean, &sd, &q[0], &q[1], &q[2], &q[3], &q[4]) != 8)
+        || (n != 4) || (sd > 1.0e-10*(1.0+fabs(mean))) || (q[0] != q[4])) {
+      printf("%-40s spread in row %d ... FAILED\n", "Ensemble run without perturbations", rows+1);
+      passed = 0;
+      break;
+    }
+    rows++;
+  }
+  free(one);
+  if (rows == 0) passed = 0;
+  if (passed) printf("%-40s same in %d rows\n", "Ensemble run without perturbations", rows);
+  return passed;
+}
+
+/* A pseudosection must not depend on the number of workers, and a refined
+   map must give at each of its points, warm started or not, what a map
+   equilibrating every point of its finest grid gives there.  Fields may be
+   numbered in another order, so rings are compared without their numbers. */
+static const char *pseudosectionGrid = "Temperature: 1100 1250 %d\nPressure: 500 5000 %d\nRefinement: %d\nWorkers: %d\n";
+
+/* the lines after the header, each from its n-th field on, sorted */
+static int compareLines(const void *a, const void *b) { return strcmp(*(char * const *) a, *(char * const *) b); }
+
+static char **csvLines(char *text, int from, int *nLines) {
+  char **lines = NULL, *line;
+  int k;
+
+  *nLines = 0;
+  if ((text == NULL) || ((line = strchr(text, '\n')) == NULL)) return NULL;
+  for (line++; *line != '\0'; ) {
+    char *end = strchr(line, '\n'), *field = line;
+    if (end != NULL) *end = '\0';
+    for (k=0; (k<from) && (field != NULL); k++) if ((field = strchr(field, ',')) != NULL) field++;
+    lines = (char **) realloc(lines, (size_t) (*nLines + 1)*sizeof(char *));
+    lines[(*nLines)++] = (field != NULL) ? field : line;
+    if (end == NULL) break;
+    line = end + 1;
+  }
+  qsort(lines, (size_t) *nLines, sizeof(char *), compareLines);
+  return lines;
+}
+
+static int runPseudosection(int nT, int nP, int refinement, int workers, const char *prefix) {
+  char grid[256], name[64], arguments[PATH_MAX];
+
+  (void) snprintf(grid, sizeof(grid), pseudosectionGrid, nT, nP, refinement, workers);
+  (void) snprintf(name, sizeof(name), "%s.txt", prefix);
+  (void) snprintf(arguments, sizeof(arguments), "-pseudosection ensemble.melts %s %s", name, prefix);
+  return writeFile(name, grid) && runBatch(arguments);
+}
+
+static int testPseudosection(void) {
+  char *text[4], **refined, **finest;
+  int nRefined, nFinest, i, j, k, passed = 1;
+
+  if (!writeFile("ensemble.melts", ensembleInput) || !runPseudosection(3, 3, 2, 1, "one") || !runPseudosection(3, 3, 2, 3, "three")
+      || !runPseudosection(9, 9, 0, 3, "finest")) {
+    printf("%-40s failed ... FAILED\n", "Pseudosection runs");
+    return 0;
+  }
+
+  text[0] = readFile("one-points.csv");
+  text[1] = readFile("three-points.csv");
+  text[2] = readFile("one-fields.csv");
+  text[3] = readFile("three-fields.csv");
+  passed &= sameOutput("Pseudosection points on 1 and 3 workers", text[0], text[1]);
+  passed &= sameOutput("Pseudosection fields on 1 and 3 workers", text[2], text[3]);
+  for (i=0; i<4; i++) free(text[i]);
+  if (!passed) return 0;
+
+  /* T, P, then after the level and warm start columns the assemblage and phases */
+  refined = csvLines(text[0] = readFile("one-points.csv"), 0, &nRefined);
+  finest  = csvLines(text[1] = readFile("finest-points.csv"), 0, &nFinest);
+  if ((nRefined == 0) || (nFinest == 0)) { printf("%-40s no points ... FAILED\n", "Refined pseudosection"); passed = 0; }
+  for (i=0, j=0; (i<nRefined) && passed; i++) {
+    char *a = refined[i], *b;
+    size_t len = (size_t) (strchr(strchr(a, ',')+1, ',') - a);
+    while ((j < nFinest) && (strncmp(finest[j], a, len) < 0)) j++;
+    if (j == nFinest) { printf("Point %.*s not in the finest map ... FAILED\n", (int) len, a); passed = 0; break; }
+    b = finest[j];
+    for (k=0; k<4; k++) { a = strchr(a, ',') + 1; b = strchr(b, ',') + 1; }
+    if (strncmp(a, b, (size_t) (strchr(a, ',') - a + 1))) {
+      printf("Point %.*s: %s, %s in the finest map ... FAILED\n", (int) len, refined[i], a, b);
+      passed = 0;
+    }
+    for (a=strchr(a, ','), b=strchr(b, ','); (a != NULL) && (b != NULL) && passed; a=strchr(a+1, ','), b=strchr(b+1, ','))
+      if (fabs(atof(a+1) - atof(b+1)) > 1.0e-4) {
+        printf("Point %.*s: proportions differ from the finest map ... FAILED\n", (int) len, refined[i]);
+        passed = 0;
+      }
+  }
+  if (passed) printf("%-40s same at %d points\n", "Refined pseudosection and finest grid", nRefined);
+  free(refined); free(finest); free(text[0]); free(text[1]);
+
+  refined = csvLines(text[0] = readFile("one-fields.csv"), 1, &nRefined);
+  finest  = csvLines(text[1] = readFile("finest-fields.csv"), 1, &nFinest);
+  for (i=0, k=(nRefined == nFinest) && (nRefined > 0); (i<nRefined) && k; i++) k = !strcmp(refined[i], finest[i]);
+  if (!k) printf("%-40s differ ... FAILED\n", "Refined pseudosection and finest fields");
+  else    printf("%-40s same\n", "Refined pseudosection and finest fields");
+  passed &= k;
+  free(refined); free(finest); free(text[0]); free(text[1]);
+  return passed;
+}
+
+/* Adaptive steps along an equilibrium path must locate each phase where a
+   path at the minimum step finds it, within that step, must agree with it
+   at the temperatures both visit, and must end at the final temperature    */
+static const char *adaptiveInput =
+  "Title: MORB adaptive steps\n"
+  "Initial Composition: SiO2 48.68\nInitial Composition: TiO2 1.01\nInitial Composition: Al2O3 17.64\n"
+  "Initial Composition: Fe2O3 0.89\nInitial Composition: Cr2O3 0.0425\nInitial Composition: FeO 7.59\n"
+  "Initial Composition: MgO 9.10\nInitial Composition: CaO 12.45\nInitial Composition: Na2O 2.65\n"
+  "Initial Composition: K2O 0.03\nInitial Composition: P2O5 0.08\nInitial Composition: H2O 0.2\n"
+  "Initial Temperature: 1260.00\nFinal Temperature: 1160.00\nIncrement Temperature: %.2f\n"
+  "Initial Pressure: 1000.00\nFinal Pressure: 1000.00\nIncrement Pressure: 0.00\n"
+  "log fo2 Path: FMQ\n%s";
+
+#define ADAPTIVE_INCREMENT 10.0
+#define ADAPTIVE_MINIMUM   1.25 /* the default Minimum Step of 0.125 increments */
+
+/* field (counted from 0) of a comma separated row, as a number */
+static double csvField(const char *row, int field) {
+  for (; (field > 0) && (row != NULL); field--) if ((row = strchr(row, ',')) != NULL) row++;
+  return (row != NULL) ? atof(row) : -1.0;
+}
+
+static int runPath(const char *directory, double increment, const char *mode) {
+  char input[2048], name[64], arguments[PATH_MAX];
+  int ok;
+
+  (void) snprintf(input, sizeof(input), adaptiveInput, increment, mode);
+  (void) snprintf(name, sizeof(name), "%s.melts", directory);
+  (void) snprintf(arguments, sizeof(arguments), "%s/%s", directory, name);
+  if ((mkdir(directory, 0755) != 0) || !writeFile(arguments, input) || chdir(directory)) return 0;
+  ok = runBatch(name);
+  return (chdir("..") == 0) && ok;
+}
+
+static int testAdaptiveSteps(void) {
+  char *events, *line, **adaptive, **fixed;
+  int nAdaptive, nFixed, nEvents = 0, nSame = 0, i, j, passed = 1;
+  double last = 0.0;
+
+  if (!runPath("adaptive", ADAPTIVE_INCREMENT, "Mode: Adaptive Steps\n") || !runPath("fixed", ADAPTIVE_MINIMUM, "")
+      || ((events = readFile("adaptive/melts-events.out")) == NULL)) {
+    printf("%-40s failed ... FAILED\n", "Adaptive and fixed step runs");
+    return 0;
+  }
+
+  /* T (C), P (bars), step, then the phase and its change in number */
+  for (line=strchr(events, '\n'); (line != NULL) && (line[1] != '\0'); line=strchr(line+1, '\n')) {
+    char phase[64], name[80], *table;
+    double t, p, step, first;
+    int from, to;
+    if ((sscanf(line+1, "%lf %lf %lf %63s %d -> %d", &t, &p, &step, phase, &from, &to) != 6) || (from != 0)) continue;
+    (void) snprintf(name, sizeof(name), "fixed/%s.tbl", phase);
+    table = readFile(name);
+    first = (table != NULL) ? csvField(strchr(table, '\n'), 1) : -1.0;
+    free(table);
+    if (fabs(t - first) > ADAPTIVE_MINIMUM + 0.01) {
+      printf("%s appears at %.3f C with adaptive steps, at %.2f C with fixed steps ... FAILED\n", phase, t, first);
+      passed = 0;
+    }
+    nEvents++;
+  }
+  free(events);
+
+  /* the index column differs, so rows are matched on T (C) */
+  adaptive = csvLines(events = readFile("adaptive/melts-liquid.tbl"), 1, &nAdaptive);
+  fixed    = csvLines(line   = readFile("fixed/melts-liquid.tbl"), 1, &nFixed);
+  for (i=0; i<nAdaptive; i++) {
+    double t = csvField(adaptive[i], 0);
+    if ((last == 0.0) || (t < last)) last = t;
+    for (j=0; j<nFixed; j++) if (csvField(fixed[j], 0) == t) break;
+    if (j == nFixed) continue;
+    nSame++;
+    if (fabs(csvField(adaptive[i], 3) - csvField(fixed[j], 3)) > 1.0e-6*csvField(fixed[j], 3)) {
+      printf("Liquid mass at %.2f C differs with adaptive steps ... FAILED\n", t);
+      passed = 0;
+    }
+  }
+  free(adaptive); free(fixed); free(events); free(line);
+
+  if ((nEvents == 0) || (nSame < 3) || (last != 1160.0)) {
+    printf("%-40s %d events, %d common temperatures, ends at %.2f C ... FAILED\n", "Adaptive steps", nEvents, nSame, last);
+    passed = 0;
+  }
+  if (passed) printf("%-40s %d events, %d temperatures as before\n", "Adaptive and fixed step runs", nEvents, nSame);
+  return passed;
+}
+
+/* removes directory and everything in it */
+static int removeAll(const char *directory) {
+  DIR *dir = opendir(directory);
+  struct dirent *dp;
+  char name[PATH_MAX];
+
+  while ((dir != NULL) && ((dp = readdir(dir)) != NULL)) if (dp->d_name[0] != '.') {
+    (void) snprintf(name, sizeof(name), "%s/%s", directory, dp->d_name);
+    if (unlink(name) != 0) (void) removeAll(name);
+  }
+  if (dir != NULL) (void) closedir(dir);
+  return (rmdir(directory) == 0);
+}
+
+int main (int argc, char *argv[]) {
+  char schema[PATH_MAX], scratch[] = "/tmp/Test_batchModesXXXXXX";
+  int passed = 1;
+
+  if ((realpath((argc > 1) ? argv[1] : "./Melts-batch", meltsBatch) == NULL) || (realpath("MELTSinput.xsd", schema) == NULL)) {
+    printf("Melts-batch or MELTSinput.xsd not found\nFAILED\n");
+    return 1;
+  }
+  if ((mkdtemp(scratch) == NULL) || chdir(scratch) || symlink(schema, "MELTSinput.xsd")) {
+    printf("Cannot set up the scratch directory\nFAILED\n");
+    return 1;
+  }
+
+  passed &= testStreamAndServer();
+  passed &= testEnsemble();
+  passed &= testPseudosection();
+  passed &= testAdaptiveSteps();
+
+  if (passed) {
+    if (chdir("/") || !removeAll(scratch)) printf("Scratch directory %s left behind\n", scratch);
+  } else printf("Runs left in %s\n", scratch);
+
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
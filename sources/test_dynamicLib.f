@@ -19,6 +19,11 @@ program test
 ! storage for meltsgetendmemberproperties
 !  
   double precision endprops(3, 20)        
+!
+! storage for the identifier based interface and its benchmark
+!
+  integer version, numproperties, liquidid, phaseids(20), maxphases, ncalls
+  double precision rowprops(20, 33), start, finish
 !     
 ! local storage
 !
@@ -186,6 +191,86 @@ program test
     print *, "... Error string: ", errorString
   end do
     
+!
+! meltsgetapiversion
+!   integer version [ return, check against the version the program was written for ]
+!   integer numoxides [ return ]
+!   integer numproperties [ return, number of properties per phase from meltsprocessv1 ]
+!
+  print *, "Before call to meltsgetapiversion..."
+  call meltsgetapiversion(version, numoxides, numproperties)
+  print *, "... version = ", version, " numoxides = ", numoxides, " numproperties = ", numproperties
+!
+! meltsgetphaseid
+!   character*n phaseName [ input, zero byte deliminated string ]
+!   integer id [ return, -1 if there is no such phase ]
+!
+  call meltsgetphaseid('liquid'//char(0), liquidid)
+  print *, "... liquid id = ", liquidid
+!
+! meltsprocessv1, as meltsprocess except
+!   integer bulkstride [ input, 1 for bulk(19) ]
+!   integer maxphases [ input, room in phaseids and properties ]
+!   integer phaseids(20) [ return, in place of phasenames and phaseIndices ]
+!   integer propertystride, phasestride [ input, layout of properties ]
+!
+! here properties are returned one row per phase, i.e. transposed from meltsprocess
+!
+  print *, "Before call to meltsprocessv1..."
+  node = 2
+  mode = 1
+  maxphases = 20
+  call meltsprocessv1(node, mode, pressure, bulk, 1, enthalpy, temperature, maxphases, numphases, phaseids, &
+  rowprops, maxphases, 1, status)
+  print *, "... status = ", status
+  do i=1,min(numphases, maxphases)
+    print *, "... phase id: ", phaseids(i), " g = ", rowprops(i, 1), " v = ", rowprops(i, 4)
+  end do
+!
+! per call cost of update runs against meltsprocess, which returns phases by name
+!
+  ncalls = 20
+  call cpu_time(start)
+  do k=1,ncalls
+    node = 1
+    call meltsprocess(node, mode, pressure, bulk, enthalpy, temperature, phasenames, 20, numphases, &
+    iterations, status, properties, phaseIndices)
+  end do
+  call cpu_time(finish)
+  print *, "... meltsprocess   milliseconds per call = ", 1.0d3*(finish-start)/ncalls
+  call cpu_time(start)
+  do k=1,ncalls
+    node = 2
+    call meltsprocessv1(node, mode, pressure, bulk, 1, enthalpy, temperature, maxphases, numphases, phaseids, &
+    rowprops, maxphases, 1, status)
+  end do
+  call cpu_time(finish)
+  print *, "... meltsprocessv1 milliseconds per call = ", 1.0d3*(finish-start)/ncalls
+!
+! meltsgetphasepropertiesv1
+!   integer id [ input, from meltsgetphaseid ]
+!   double precision temperature, pressure, bulk(19) [ input, as meltsgetphaseproperties ]
+!   integer bulkstride [ input ]
+!   double precision properties(11) [ return ]
+!   integer propertystride [ input ]
+!   integer status [ return ]
+!
+! per call cost against meltsgetphaseproperties, which looks up the phase by name
+!
+  ncalls = 10000
+  call cpu_time(start)
+  do k=1,ncalls
+    call meltsgetphaseproperties('liquid'//char(0), temperature, pressure, bulk, properties)
+  end do
+  call cpu_time(finish)
+  print *, "... meltsgetphaseproperties   microseconds per call = ", 1.0d6*(finish-start)/ncalls
+  call cpu_time(start)
+  do k=1,ncalls
+    call meltsgetphasepropertiesv1(liquidid, temperature, pressure, bulk, 1, properties, 1, status)
+  end do
+  call cpu_time(finish)
+  print *, "... meltsgetphasepropertiesv1 microseconds per call = ", 1.0d6*(finish-start)/ncalls
+
   print *, "Before call to meltsgetphaseproperties..."
 !
 ! meltsgetphaseproperties
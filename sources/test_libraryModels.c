@@ -0,0 +1,534 @@
+/*
+**++
+**  FACILITY:  Silicate Melts Crystallization Package
+**
+**  MODULE DESCRIPTION:
+**
+**      Test of switching calibrations in libMelts (file: TEST_LIBRARYMODELS.C)
+**
+**      Test_libraryModels
+**
+**      Equilibrates the same MORB node with rhyolite-MELTS 1.0.2, then
+**      with rhyolite-MELTS 1.2 (whose solid table is larger), then with
+**      pMELTS, and then again with rhyolite-MELTS 1.2 and 1.0.2.  The
+**      repeated calculations must reproduce the phases and properties of
+**      the first ones.  Then checks that a small change of bulk
+**      composition, warm-started from the converged node, agrees with a
+**      cold start, also after meltssaturationstate_() has rewritten the
+**      state of the node, and that the properties of a node are right
+**      after the sensitivities of another node at a different temperature.
+**      With memoization, a repeated call must be answered from stored
+**      results, and a call with another bulk composition or after
+**      meltssaturationstate_() must equilibrate again.  The state of a
+**      fractionating node must survive packing, directly and while the
+**      library holds the node compact.  Beyond a node limit the node used
+**      least recently must be released, and equilibrate as before once it
+**      is created again.  An equilibration that exhausts its budget must
+**      return status 106.  A liquidus search started from the liquidus
+**      temperatures of nearby compositions must find the same liquidus.
+**      The system column of every result must be the sum of the phases.
+**      Exits with a non-zero status on failure.
+**--
+*/
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "silmin.h"
+
+int setCalculationMode(int mode);
+void meltsgetoxidenames_(char oxideNames[], int *nCharInName, int *numberOxides);
+void meltssaturationstate_(int *nodeIndex, double *pressure, double *bulkComposition, double *temperature,
+                           char phaseNames[], int *nCharInName, int *numberPhases, double *phaseProperties,
+                           int phaseIndices[]);
+void meltsgetsensitivities_(int *nodeIndex, char phaseNames[], int *nCharInName, int *numberPhases,
+                            double *sensitivities, int phaseIndices[], int *status);
+void meltsgetallphaseproperties_(int *nodeIndex, char phaseNames[], int *nCharInName, int *numberPhases,
+                                 double *phaseProperties, int phaseIndices[]);
+void meltssetmemoization_(int *enable, double *tolerance);
+void meltssetsystemproperty_(int *nodeIndex, char *property);
+void meltssetcompactnodes_(int *enable);
+void meltsgetnodememory_(int *nodes, int *compact, double *bytes);
+void meltssetnodelimit_(int *limit);
+void meltssetbudget_(double *wallTime, int *quadIterations, int *speciationIterations);
+void meltsgetmemostatistics_(int *hits, int *misses);
+void meltssetliquidussurrogate_(int *enable);
+void meltsprocess_(int *nodeIndex, int *mode, double *pressure, double *bulkComposition,
+                   double *enthalpy, double *temperature, char phaseNames[], int *nCharInName,
+                   int *numberPhases, int *iterations, int *status, double *phaseProperties,
+                   int phaseIndices[]);
+
+#define NAME_LENGTH 20
+#define MAX_PHASES  20
+
+typedef struct _nodeResult {
+  int    status;
+  int    numberPhases;
+  char   phaseNames[MAX_PHASES*NAME_LENGTH];
+  double phaseProperties[MAX_PHASES*(11+20+3)];
+} NodeResult;
+
+static int numberOxides, numberProperties;
+
+static const double morb[20] = { 48.68, 1.01, 17.64, 0.89, 0.0425, 7.59, 0.0, 9.10, 0.0, 0.0,
+                                 12.45, 2.65, 0.03, 0.08, 0.20, 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+/* Equilibrates node with bulk (grams of oxides) at temperature (K) and 1 kbar,
+   fractionating after the properties are returned if output is 1           */
+static void runNodeOutput(int node, const double *bulkIn, double temperature, int output, NodeResult *result) {
+  double bulk[20], pressure = 1000.0, enthalpy = 0.0;
+  int mode = 1, nCh = NAME_LENGTH, iterations = output, phaseIndices[MAX_PHASES];
+
+  memcpy(bulk, bulkIn, sizeof(bulk));
+  result->numberPhases = MAX_PHASES;
+  meltsprocess_(&node, &mode, &pressure, bulk, &enthalpy, &temperature, result->phaseNames, &nCh,
+                &(result->numberPhases), &iterations, &(result->status), result->phaseProperties,
+                phaseIndices);
+}
+
+static void runNodeAt(int node, const double *bulkIn, double temperature, NodeResult *result) {
+  runNodeOutput(node, bulkIn, temperature, 0, result);
+}
+
+static void runNodeWith(int node, const double *bulkIn, NodeResult *result) {
+  runNodeAt(node, bulkIn, 1473.15, result);
+}
+
+static void runNode(int node, NodeResult *result) {
+  runNodeWith(node, morb, result);
+}
+
+static int sameResultWithin(const char *label, NodeResult *first, NodeResult *second, double tolerance) {
+  int i;
+
+  if ((first->status != second->status) || (first->numberPhases != second->numberPhases)) {
+    printf("%s: status %d/%d, %d/%d phases.\n", label, first->status, second->status,
+           first->numberPhases, second->numberPhases);
+    return FALSE;
+  }
+  if (strncmp(first->phaseNames, second->phaseNames, (size_t) first->numberPhases*NAME_LENGTH) != 0) {
+    printf("%s: different phase assemblages.\n", label);
+    return FALSE;
+  }
+  for (i=0; i<first->numberPhases*numberProperties; i++)
+    if (fabs(first->phaseProperties[i]-second->phaseProperties[i])
+        > tolerance*(1.0+fabs(first->phaseProperties[i]))) {
+      printf("%s: property %d of phase %.*s differs, %g/%g.\n", label, i % numberProperties,
+             NAME_LENGTH, first->phaseNames + (i/numberProperties)*NAME_LENGTH,
+             first->phaseProperties[i], second->phaseProperties[i]);
+      return FALSE;
+    }
+  printf("%s: %d phases, as before.\n", label, first->numberPhases);
+  return TRUE;
+}
+
+/* The thermodynamic properties (G through d2VdP2) and the grams of each oxide of
+   the system must be the sums of those of the phases                          */
+static int systemIsSum(const char *label, NodeResult *result) {
+  int i, k;
+
+  for (i=0; i<11+numberOxides; i++) {
+    double sum = 0.0, scale = 0.0;
+    for (k=1; k<result->numberPhases; k++) {
+      sum   += result->phaseProperties[k*numberProperties+i];
+      scale += fabs(result->phaseProperties[k*numberProperties+i]);
+    }
+    if (fabs(result->phaseProperties[i]-sum) > 1.0e-8*scale + DBL_MIN) {
+      printf("%s: system property %d is %g, the phases sum to %g.\n", label, i, result->phaseProperties[i], sum);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static int sameResult(const char *label, NodeResult *first, NodeResult *second) {
+  return sameResultWithin(label, first, second, 1.0e-8);
+}
+
+/* A small change of bulk composition re-equilibrates a converged node from its
+   assemblage; the result must agree with a cold start, and a node whose state
+   was rewritten by meltssaturationstate_() must not be taken as converged    */
+static int testWarmStart(void) {
+  static NodeResult warm, cold, result;
+  static char names[100*NAME_LENGTH];
+  static double properties[100*21], sensitivities[MAX_PHASES*22*20];
+  double bulk[20], changed[20], pressure = 1000.0, temperature = 1473.15;
+  int node = 10, nCh = NAME_LENGTH, numberPhases = 100, indices[100], status, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  memcpy(changed, morb, sizeof(changed));
+  changed[5] += 0.005; /* MgO, well within the warm start limit */
+
+  runNodeWith(10, morb, &result);
+  runNodeWith(10, changed, &warm);
+  runNodeWith(11, changed, &cold);
+  passed &= sameResultWithin("warm start against cold start", &cold, &warm, 1.0e-6);
+
+  memcpy(bulk, morb, sizeof(bulk));
+  bulk[0] += 0.02;     /* SiO2 */
+  meltssaturationstate_(&node, &pressure, bulk, &temperature, names, &nCh, &numberPhases, properties, indices);
+  meltsgetsensitivities_(&node, names, &nCh, &numberPhases, sensitivities, indices, &status);
+  if (status != 107) {
+    printf("meltsgetsensitivities after meltssaturationstate: status %d, not 107.\n", status);
+    passed = FALSE;
+  }
+  runNodeWith(10, changed, &warm);
+  passed &= sameResultWithin("update after meltssaturationstate against cold start", &cold, &warm, 1.0e-6);
+
+  return passed;
+}
+
+/* Sensitivities evaluate end-member properties at the T and P of their node,
+   after which the properties of another node must not reuse them          */
+static int testSensitivities(void) {
+  static NodeResult other, result;
+  static char names[MAX_PHASES*NAME_LENGTH];
+  static double sensitivities[MAX_PHASES*22*20];
+  int node = 30, otherNode = 31, nCh = NAME_LENGTH, numberPhases, indices[MAX_PHASES], status, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  runNodeAt(node, morb, 1473.15, &result);
+  runNodeAt(otherNode, morb, 1448.15, &other);
+  meltsgetsensitivities_(&node, names, &nCh, &numberPhases, sensitivities, indices, &status);
+  if ((status != 0) || (numberPhases != result.numberPhases-1)) {
+    printf("meltsgetsensitivities: status %d, %d phases.\n", status, numberPhases);
+    passed = FALSE;
+  }
+  result.status = other.status;
+  meltsgetallphaseproperties_(&otherNode, result.phaseNames, &nCh, &(result.numberPhases), result.phaseProperties, indices);
+  passed &= sameResult("meltsgetallphaseproperties after meltsgetsensitivities of another node", &other, &result);
+  passed &= systemIsSum("meltsgetallphaseproperties", &result);
+
+  return passed;
+}
+
+static int memoCounts(const char *label, int hits, int misses) {
+  int memoHits, memoMisses;
+
+  meltsgetmemostatistics_(&memoHits, &memoMisses);
+  if ((memoHits != hits) || (memoMisses != misses)) {
+    printf("%s: %d hits and %d misses, not %d and %d.\n", label, memoHits, memoMisses, hits, misses);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* A repeated call is answered from the stored results of the node, while a
+   call with another bulk composition, or after meltssaturationstate_() has
+   rewritten the node, must equilibrate again                              */
+static int testMemoization(void) {
+  static NodeResult first, result, cold;
+  static char names[100*NAME_LENGTH];
+  static double properties[100*21];
+  double bulk[20], changed[20], pressure = 1000.0, temperature = 1473.15, tolerance = 0.0;
+  int node = 40, nCh = NAME_LENGTH, numberPhases = 100, indices[100], enable = TRUE, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  memcpy(changed, morb, sizeof(changed));
+  changed[5] += 0.005; /* MgO */
+  runNodeWith(41, changed, &cold);
+
+  meltssetmemoization_(&enable, &tolerance);
+  runNodeWith(node, morb, &first);
+  runNodeWith(node, morb, &result);
+  passed &= memoCounts("repeated call", 1, 1) && sameResult("memoized result", &first, &result);
+
+  runNodeWith(node, changed, &result);
+  passed &= memoCounts("changed bulk composition", 1, 2)
+            && sameResultWithin("memoized node, changed bulk, against cold start", &cold, &result, 1.0e-6);
+  runNodeWith(node, changed, &result);
+  passed &= memoCounts("repeated changed call", 2, 2);
+
+  memcpy(bulk, changed, sizeof(bulk));
+  meltssaturationstate_(&node, &pressure, bulk, &temperature, names, &nCh, &numberPhases, properties, indices);
+  runNodeWith(node, changed, &result);
+  passed &= memoCounts("call after meltssaturationstate", 2, 3)
+            && sameResultWithin("memoized node after meltssaturationstate against cold start", &cold, &result, 1.0e-6);
+
+  enable = FALSE;
+  meltssetmemoization_(&enable, &tolerance);
+  return passed;
+}
+
+static int sameDoubles(const double *a, const double *b, int n) {
+  return (n == 0) || (memcmp(a, b, (size_t) n*sizeof(double)) == 0);
+}
+
+/* Every member that packSilminState() stores must be unpacked unchanged */
+static int sameState(SilminState *a, SilminState *b) {
+  int i, k, ns;
+
+  if ((a->T != b->T) || (a->P != b->P) || (a->fo2 != b->fo2) || (a->fo2Path != b->fo2Path)
+      || (a->liquidMass != b->liquidMass) || (a->solidMass != b->solidMass) || (a->fracMass != b->fracMass)
+      || (a->fractionateSol != b->fractionateSol) || (a->nLiquidCoexist != b->nLiquidCoexist)) return FALSE;
+  if (!sameDoubles(a->bulkComp, b->bulkComp, nc) || !sameDoubles(a->dspBulkComp, b->dspBulkComp, nc)) return FALSE;
+  for (i=0; i<MAX(1, a->nLiquidCoexist); i++)
+    if (!sameDoubles((a->liquidComp)[i], (b->liquidComp)[i], nlc)
+        || !sameDoubles((a->liquidDelta)[i], (b->liquidDelta)[i], nlc)) return FALSE;
+  for (i=0; i<=npc; i++) if ((a->incSolids)[i] != (b->incSolids)[i]) return FALSE;
+  for (i=0; i<npc; i++) {
+    if (((a->nSolidCoexist)[i] != (b->nSolidCoexist)[i]) || ((a->cylSolids)[i] != (b->cylSolids)[i])) return FALSE;
+    if (((ns = (a->nSolidCoexist)[i]) > 0) && (solids[i].type == PHASE))
+      for (k=0; k<((solids[i].na > 1) ? 1+solids[i].na : 1); k++)
+        if (!sameDoubles((a->solidComp)[i+k], (b->solidComp)[i+k], ns)
+            || !sameDoubles((a->solidDelta)[i+k], (b->solidDelta)[i+k], ns)) return FALSE;
+  }
+  if ((a->fracSComp == NULL) != (b->fracSComp == NULL)) return FALSE;
+  if (a->fracSComp != NULL) for (i=0; i<npc; i++) {
+    if ((a->nFracCoexist)[i] != (b->nFracCoexist)[i]) return FALSE;
+    if ((ns = (a->nFracCoexist)[i]) > 0)
+      for (k=0; k<((solids[i].na > 1) ? 1+solids[i].na : 1); k++)
+        if (!sameDoubles((a->fracSComp)[i+k], (b->fracSComp)[i+k], ns)) return FALSE;
+  }
+  if ((a->fracLComp == NULL) != (b->fracLComp == NULL)) return FALSE;
+  return (a->fracLComp == NULL) || sameDoubles(a->fracLComp, b->fracLComp, nlc);
+}
+
+/* A fractionating node is packed and unpacked directly, and then held compact
+   by the library while another node is used; neither may change its state   */
+static int testCompactState(void) {
+  static NodeResult first, before, other, result;
+  static char fractionate[] = "Mode: Fractionate Solids";
+  SilminState *unpacked;
+  CompactState *packed;
+  double bytes;
+  int i, node = 50, otherNode = 51, nCh = NAME_LENGTH, nodes, compact, indices[MAX_PHASES], enable = TRUE, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  meltssetsystemproperty_(&node, fractionate);
+  runNodeOutput(node, morb, 1473.15, 1, &first);
+  runNodeOutput(node, morb, 1448.15, 1, &first);
+
+  /* silminState is that of the node last used */
+  if ((packed = packSilminState(silminState)) == NULL) {
+    printf("packSilminState refused the state of a fractionating node.\n");
+    return FALSE;
+  }
+  unpacked = unpackSilminState(packed);
+  if ((unpacked->fracSComp == NULL) || (unpacked->fracMass == 0.0)) {
+    printf("no solids fractionated from the node.\n");
+    passed = FALSE;
+  }
+  if (!sameState(silminState, unpacked)) {
+    printf("unpackSilminState(packSilminState()) differs from the state packed.\n");
+    passed = FALSE;
+  } else printf("packed and unpacked state of a fractionating node, as before.\n");
+  free(packed);
+
+  before.status = first.status;
+  meltsgetallphaseproperties_(&node, before.phaseNames, &nCh, &(before.numberPhases), before.phaseProperties, indices);
+
+  meltssetcompactnodes_(&enable);
+  runNodeAt(otherNode, morb, 1473.15, &other);
+  meltsgetnodememory_(&nodes, &compact, &bytes);
+  if (compact < 1) {
+    printf("no node held compact.\n");
+    passed = FALSE;
+  }
+  result.status = first.status;
+  meltsgetallphaseproperties_(&node, result.phaseNames, &nCh, &(result.numberPhases), result.phaseProperties, indices);
+  passed &= sameResult("meltsgetallphaseproperties of a node held compact", &before, &result);
+  if (!sameState(silminState, unpacked)) {
+    printf("state of a node held compact differs from the state before.\n");
+    passed = FALSE;
+  }
+
+  if (unpacked->fracSComp != NULL) {
+    for (i=0; i<npc; i++) free((unpacked->fracSComp)[i]);
+    free(unpacked->fracSComp);
+    free(unpacked->nFracCoexist);
+  }
+  free(unpacked->fracLComp);
+  destroySilminStateStructure(unpacked);
+
+  enable = FALSE;
+  meltssetcompactnodes_(&enable);
+  return passed;
+}
+
+static int sensitivitiesStatus(int node) {
+  static char names[MAX_PHASES*NAME_LENGTH];
+  static double sensitivities[MAX_PHASES*22*20];
+  int nCh = NAME_LENGTH, numberPhases, indices[MAX_PHASES], status;
+
+  meltsgetsensitivities_(&node, names, &nCh, &numberPhases, sensitivities, indices, &status);
+  return status;
+}
+
+/* Beyond the node limit the node used least recently is released, and a later
+   call for it starts again from a new state                                 */
+static int testNodeLimit(void) {
+  static NodeResult first, second, result;
+  double bytes;
+  int limit = 2, nodes, compact, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  runNodeWith(60, morb, &first);
+  runNodeWith(61, morb, &second);
+  meltssetnodelimit_(&limit);
+  meltsgetnodememory_(&nodes, &compact, &bytes);
+  if (nodes != limit) {
+    printf("%d nodes kept with a limit of %d.\n", nodes, limit);
+    passed = FALSE;
+  }
+
+  runNodeWith(60, morb, &result); /* 61 is now the node used least recently */
+  runNodeWith(62, morb, &result);
+  meltsgetnodememory_(&nodes, &compact, &bytes);
+  if ((nodes != limit) || (sensitivitiesStatus(61) != 107) || (sensitivitiesStatus(60) != 0)) {
+    printf("%d nodes kept with a limit of %d, node 61 not released or node 60 released.\n", nodes, limit);
+    passed = FALSE;
+  }
+
+  /* asking for the sensitivities of node 60 used it after node 62 */
+  runNodeWith(61, morb, &result);
+  passed &= sameResult("node released at the limit and created again", &second, &result);
+  if ((sensitivitiesStatus(60) != 0) || (sensitivitiesStatus(62) != 107)) {
+    printf("node 60 released, or node 62 not released.\n");
+    passed = FALSE;
+  }
+
+  limit = 0;
+  meltssetnodelimit_(&limit);
+  return passed;
+}
+
+static void setBudget(double wallTime, int quadIterations) {
+  int speciationIterations = 0;
+  meltssetbudget_(&wallTime, &quadIterations, &speciationIterations);
+}
+
+/* An equilibration that exhausts its budget returns status 106 with the best
+   state found, while a budget it does not reach leaves the result unchanged */
+static int testBudget(void) {
+  static NodeResult reference, result;
+  int passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  runNodeWith(70, morb, &reference);
+
+  setBudget(0.0, 2);
+  runNodeWith(71, morb, &result);
+  if ((result.status != 106) || (result.numberPhases < 2) || !systemIsSum("quadratic iteration budget", &result)) {
+    printf("quadratic iteration budget: status %d, %d phases.\n", result.status, result.numberPhases);
+    passed = FALSE;
+  }
+
+  setBudget(1.0e-9, 0);
+  runNodeWith(72, morb, &result);
+  if (result.status != 106) {
+    printf("time budget: status %d.\n", result.status);
+    passed = FALSE;
+  }
+
+  setBudget(60.0, 1000);
+  runNodeWith(73, morb, &result);
+  passed &= sameResult("budget not reached", &reference, &result);
+
+  setBudget(0.0, 0);
+  return passed;
+}
+
+/* Finds the liquidus of node with bulk (grams of oxides) at 1 kbar, starting
+   from 1200 C; returns the status and sets temperature (K)                  */
+static int runLiquidus(int node, const double *bulkIn, double *temperature) {
+  double bulk[20], pressure = 1000.0, enthalpy = 0.0, phaseProperties[MAX_PHASES*(11+20+3)];
+  char phaseNames[MAX_PHASES*NAME_LENGTH];
+  int mode = 0, nCh = NAME_LENGTH, numberPhases = MAX_PHASES, iterations = 0, status, phaseIndices[MAX_PHASES];
+
+  memcpy(bulk, bulkIn, sizeof(bulk));
+  *temperature = 1473.15;
+  meltsprocess_(&node, &mode, &pressure, bulk, &enthalpy, temperature, phaseNames, &nCh,
+                &numberPhases, &iterations, &status, phaseProperties, phaseIndices);
+  return status;
+}
+
+/* Searches started from the liquidus temperatures of nearby compositions must
+   find the liquidus found from a fixed start.  Each search ends within 0.2 K
+   of the liquidus (its last step before the step falls to 0.1 K), so two
+   searches may differ by 0.4 K.  The last composition is far enough from the
+   others that the first steps from its prediction do not bracket it.        */
+#define N_LIQUIDUS 9
+
+static int testLiquidusSurrogate(void) {
+  double bulk[20], reference[N_LIQUIDUS], temperature;
+  int i, k, enable, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  for (enable=FALSE; enable<=TRUE; enable++) {
+    meltssetliquidussurrogate_(&enable);
+    for (k=0; k<N_LIQUIDUS; k++) {
+      int status;
+      for (i=0; i<20; i++) bulk[i] = morb[i];
+      bulk[7] = (k < N_LIQUIDUS-1) ? 8.8 + 0.1*k : 10.8; /* MgO */
+      status = runLiquidus(80 + 10*enable + k, bulk, &temperature);
+      if (status != 500) {
+        printf("liquidus %d%s: status %d.\n", k, enable ? " (surrogate)" : "", status);
+        passed = FALSE;
+      } else if (!enable) reference[k] = temperature;
+      else if (fabs(temperature-reference[k]) > 0.4) {
+        printf("liquidus %d: %.3f K from the surrogate, %.3f K from a fixed start.\n", k, temperature, reference[k]);
+        passed = FALSE;
+      }
+    }
+  }
+  enable = FALSE;
+  meltssetliquidussurrogate_(&enable);
+  if (passed) printf("liquidus from the surrogate: %d compositions, as before.\n", N_LIQUIDUS);
+  return passed;
+}
+
+int main(int argc, char *argv[]) {
+  static NodeResult melts, meltsFluid, pMelts, result;
+  char oxideNames[20*NAME_LENGTH];
+  int nCh = NAME_LENGTH, passed = TRUE;
+
+  (void) setCalculationMode(MODE__MELTS);
+  meltsgetoxidenames_(oxideNames, &nCh, &numberOxides);
+  numberProperties = 11 + numberOxides + 3;
+
+  runNode(1, &melts);
+  if (!setCalculationMode(MODE__MELTSandCO2_H2O)) {
+    printf("rhyolite-MELTS 1.0.2 -> 1.2 refused.\n");
+    return 1;
+  }
+  runNode(2, &meltsFluid);
+  if (!setCalculationMode(MODE_pMELTS)) {
+    printf("rhyolite-MELTS 1.2 -> pMELTS refused.\n");
+    return 1;
+  }
+  runNode(3, &pMelts);
+  if ((meltsFluid.status != 0) || (meltsFluid.numberPhases < 2) || (pMelts.status != 0)) {
+    printf("Initial calculations failed, status %d and %d.\n", meltsFluid.status, pMelts.status);
+    return 1;
+  }
+  passed &= systemIsSum("rhyolite-MELTS 1.0.2", &melts) && systemIsSum("rhyolite-MELTS 1.2", &meltsFluid)
+            && systemIsSum("pMELTS", &pMelts);
+
+  (void) setCalculationMode(MODE__MELTSandCO2_H2O);
+  runNode(4, &result);
+  passed &= sameResult("rhyolite-MELTS 1.2 after pMELTS", &meltsFluid, &result);
+
+  (void) setCalculationMode(MODE__MELTS);
+  runNode(5, &result);
+  passed &= sameResult("rhyolite-MELTS 1.0.2 after 1.2 and pMELTS", &melts, &result);
+
+  /* nodes keep the calibration they were created with */
+  (void) setCalculationMode(MODE_pMELTS);
+  runNode(2, &result);
+  passed &= (result.status == 0) && (result.numberPhases == meltsFluid.numberPhases);
+
+  passed &= testWarmStart();
+  passed &= testSensitivities();
+  passed &= testMemoization();
+  passed &= testCompactState();
+  passed &= testNodeLimit();
+  passed &= testBudget();
+  passed &= testLiquidusSurrogate();
+
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nash.h"
+
+/* Checks the multi-point linear search min1dn() against the one-point search
+   min1d() on functions with a known minimum, including a minimum against a
+   region where the function cannot be computed, as at a bound of the
+   quadratic step in silmin.c. The search must not end while the bracket
+   about the minimum is still wide. Against a bound the bracket is only
+   halved on each pass, so that case is run to a looser tolerance.           */
+
+#define N_POINTS 5
+#define TOLERANCE 1.0e-10
+#define TOLERANCE_BOUNDED 1.0e-6
+
+static int which;
+
+static double f(double x, int *notcomp) {
+  *notcomp = 0;
+  switch (which) {
+    case 0: return (x-0.7)*(x-0.7);
+    case 1: return pow(x-0.3, 4.0) + 0.01*(x-0.3)*(x-0.3);
+    case 2: return exp(x) - 2.0*x;
+    case 3: if (x > 0.25) *notcomp = 1; return -x;
+    default: return 0.0;
+  }
+}
+
+static double fn1d(double x, int *notcomp) { return f(x, notcomp); }
+
+static void fnnd(int n, double *x, double *fn, int *notcomp) {
+  int i;
+  for (i=0; i<n; i++) fn[i] = f(x[i], &notcomp[i]);
+}
+
+int main (int argc, char *argv[]) {
+  const char *name[]    = { "quadratic", "quartic", "exponential", "bounded" };
+  const double xMin[]   = { 0.7, 0.3, log(2.0), 0.25 };
+  const double xStart[] = { 1.0, 1.0, 1.0, 0.0 };
+  int passed = 1;
+
+  for (which=0; which<4; which++) {
+    double x, st, fmin, reltest = (which == 3) ? TOLERANCE_BOUNDED : TOLERANCE;
+    int ifn, status;
+
+    x = xStart[which]; st = 0.1; ifn = 100;
+    status = min1d(&x, &st, reltest, &ifn, &fmin, fn1d);
+    printf("%-12s min1d:  status %d, %3d evaluations, error %9.2e\n", name[which], status, ifn, fabs(x - xMin[which]));
+
+    x = xStart[which]; st = 0.1; ifn = 100;
+    status = min1dn(N_POINTS, &x, &st, reltest, &ifn, &fmin, fnnd);
+    printf("%-12s min1dn: status %d, %3d evaluations, error %9.2e\n", name[which], status, ifn, fabs(x - xMin[which]));
+    if ((status != MIN1D_SUCCESS) || (fabs(x - xMin[which]) > reltest)) {
+      printf("  ... FAILED\n");
+      passed = 0;
+    }
+  }
+
+  printf("%s\n", passed ? "PASSED" : "FAILED");
+  return passed ? 0 : 1;
+}
@@ -14,6 +14,11 @@ extern int sa_(const integer *n, doublereal *x, integer *max, doublereal *rt, do
   doublereal *vm, doublereal *xopt, doublereal *fopt, integer *nacc, integer *nfcnev,
   integer *nobds, integer *ier, doublereal *fstar, doublereal *xp, integer *nacp);
 
+extern int saParallelTempering(int n, double *x, int max, int nChains, double tMin, double tMax, double rt,
+  int ns, int nt, int neps, double eps, int maxevl, double *lb, double *ub, double *c,
+  double *vm, unsigned long seed, int nWorkers, FILE *trace,
+  double *xopt, double *fopt, int *nacc, int *nfcnev, int *nswap);
+
 int fcn_(integer *n, doublereal *theta, doublereal*h) {
   double x = theta[0]/(theta[0]+theta[1]);
   *h = 8.3143*x*log(x) + 8.3143*(1.0-x)*log(1.0-x) + 20.0*x*(1.0-x) - (0.473932799*x - 1.055282429);
@@ -83,5 +88,29 @@ int main (int argc, char *argv[]) {
   
   printf("\n\nX = %g\n\n", xopt[0]/(xopt[0]+xopt[1]));
 
+  {
+    int nChains = 8, nWorkers = 4, ptNacc, ptNfcnev, ptNswap, ptIer;
+
+    x[0] = 0.2;
+    x[1] = 0.8;
+    for (i=0; i<n; i++) vm[i] = 1.0;
+
+    printf("\nparallel tempering example");
+    printf("\nchains: %d temperatures: %g to %g rt: %g workers: %d", nChains, 0.05, 5.0, rt, nWorkers);
+
+    ptIer = saParallelTempering((int) n, x, (int) max, nChains, 0.05, 5.0, rt, (int) ns, (int) nt, (int) neps, eps,
+      (int) maxevl, lb, ub, c, vm, 1, nWorkers, NULL, xopt, &fopt, &ptNacc, &ptNfcnev, &ptNswap);
+
+    printf("\n   ****   results after parallel tempering   ****   ");
+    printf("\n   solution = %g,%g", xopt[0], xopt[1]);
+    printf("\noptimal function value: %g", fopt);
+    printf("\nnumber of function evaluations: %d", ptNfcnev);
+    printf("\nnumber of accepted evaluations: %d", ptNacc);
+    printf("\nnumber of exchanges: %d", ptNswap);
+    printf("\nier: %d", ptIer);
+
+    printf("\n\nX = %g\n\n", xopt[0]/(xopt[0]+xopt[1]));
+  }
+
   exit(0);
 }